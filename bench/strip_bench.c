@@ -0,0 +1,225 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @brief `//` 注释删除内核的微基准
+ *
+ * 用法: strip_bench [source_file] [min_mb]
+ *
+ * 把 `source_file` (默认 src/doc.c) 重复拼接成至少 `min_mb` MB
+ * (默认 16) 的 amalgamation 风格输入, 分别测量旧的逐字节状态机和
+ * 各个 scan 实现的吞吐量, 并校验输出一致。
+ */
+
+#include <scan.h>
+#include <strip.h>
+
+#include <std/allocer/bump/bump.h>
+#include <std/allocer/bump/glue.h>
+#include <std/io/file.h>
+#include <std/string/string.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 5
+
+typedef enum {
+  LEGACY_CODE,
+  LEGACY_LINE_COMMENT,
+  LEGACY_BLOCK_COMMENT,
+  LEGACY_STRING,
+  LEGACY_CHAR,
+} legacy_state_t;
+
+/**
+ * @brief 旧版 clean_single_file 的逐字节状态机, 作为对照
+ */
+static void legacy_strip(str_slice_t content, string_t *builder) {
+  legacy_state_t state = LEGACY_CODE;
+  const char *p = content.ptr;
+  const char *end = content.ptr + content.len;
+
+  while (p < end) {
+    char c = *p;
+    char next = (p + 1 < end) ? *(p + 1) : '\0';
+
+    switch (state) {
+    case LEGACY_CODE:
+      if (c == '/' && next == '/') {
+        state = LEGACY_LINE_COMMENT;
+        p++;
+      } else if (c == '/' && next == '*') {
+        state = LEGACY_BLOCK_COMMENT;
+        string_push(builder, c);
+        string_push(builder, next);
+        p++;
+      } else if (c == '"') {
+        state = LEGACY_STRING;
+        string_push(builder, c);
+      } else if (c == '\'') {
+        state = LEGACY_CHAR;
+        string_push(builder, c);
+      } else {
+        string_push(builder, c);
+      }
+      break;
+    case LEGACY_LINE_COMMENT:
+      if (c == '\n') {
+        state = LEGACY_CODE;
+        string_push(builder, c);
+      }
+      break;
+    case LEGACY_BLOCK_COMMENT:
+      string_push(builder, c);
+      if (c == '*' && next == '/') {
+        state = LEGACY_CODE;
+        string_push(builder, next);
+        p++;
+      }
+      break;
+    case LEGACY_STRING:
+      string_push(builder, c);
+      if (c == '\\') {
+        if (next != '\0') {
+          string_push(builder, next);
+          p++;
+        }
+      } else if (c == '"') {
+        state = LEGACY_CODE;
+      }
+      break;
+    case LEGACY_CHAR:
+      string_push(builder, c);
+      if (c == '\\') {
+        if (next != '\0') {
+          string_push(builder, next);
+          p++;
+        }
+      } else if (c == '\'') {
+        state = LEGACY_CODE;
+      }
+      break;
+    }
+    p++;
+  }
+}
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief 运行一个变体 BENCH_ROUNDS 次, 打印最好的一次吞吐量
+ *
+ * @param find  scan 实现; 为 NULL 时运行旧版状态机
+ */
+static bool run_variant(const char *name, scan_fn_t find, str_slice_t input,
+                        str_slice_t *out_result) {
+  double best = 0.0;
+
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    bump_t arena;
+    bump_init(&arena);
+    allocer_t alc = bump_to_allocer(&arena);
+
+    string_t out;
+    if (!string_init(&out, &alc, input.len)) {
+      bump_destroy(&arena);
+      return false;
+    }
+
+    double start = now_seconds();
+    if (find)
+      strip_line_comments(find, input, &out);
+    else
+      legacy_strip(input, &out);
+    double elapsed = now_seconds() - start;
+
+    double rate = (double)input.len / elapsed;
+    if (rate > best)
+      best = rate;
+
+    if (round == 0 && out_result) {
+      str_slice_t produced = string_as_slice(&out);
+      if (out_result->ptr == NULL) {
+        char *copy = malloc(produced.len + 1);
+        if (!copy) {
+          bump_destroy(&arena);
+          return false;
+        }
+        memcpy(copy, produced.ptr, produced.len);
+        *out_result = (str_slice_t){.ptr = copy, .len = produced.len};
+      } else if (produced.len != out_result->len ||
+                 memcmp(produced.ptr, out_result->ptr, produced.len) != 0) {
+        fprintf(stderr, "  %-8s output differs from legacy!\n", name);
+        bump_destroy(&arena);
+        return false;
+      }
+    }
+    bump_destroy(&arena);
+  }
+
+  printf("  %-8s %10.1f MB/s\n", name, best / (1024.0 * 1024.0));
+  return true;
+}
+
+int main(int argc, const char **argv) {
+  const char *source = argc > 1 ? argv[1] : "src/doc.c";
+  size_t min_mb = argc > 2 ? strtoul(argv[2], NULL, 10) : 16;
+
+  bump_t arena;
+  bump_init(&arena);
+  allocer_t alc = bump_to_allocer(&arena);
+
+  str_slice_t unit;
+  if (!read_file_to_slice(&alc, source, &unit) || unit.len == 0) {
+    fprintf(stderr, "Error: Failed to read '%s'\n", source);
+    bump_destroy(&arena);
+    return 1;
+  }
+
+  string_t amalgamation;
+  string_init(&amalgamation, &alc, min_mb * 1024 * 1024 + unit.len);
+  while (string_as_slice(&amalgamation).len < min_mb * 1024 * 1024) {
+    string_append_slice(&amalgamation, unit);
+  }
+  str_slice_t input = string_as_slice(&amalgamation);
+
+  printf("strip_line_comments: %.1f MB input (%s), default scan: %s\n",
+         (double)input.len / (1024.0 * 1024.0), source, scan_impl_name());
+
+  str_slice_t reference = {0};
+  bool ok = run_variant("legacy", NULL, input, &reference);
+
+  static const char *const impls[] = {"scalar", "sse2", "avx2"};
+  for (size_t i = 0; ok && i < sizeof(impls) / sizeof(impls[0]); i++) {
+    scan_fn_t find = scan_impl(impls[i]);
+    if (!find) {
+      printf("  %-8s (not supported on this CPU)\n", impls[i]);
+      continue;
+    }
+    ok = run_variant(impls[i], find, input, &reference);
+  }
+
+  free((void *)reference.ptr);
+  bump_destroy(&arena);
+  return ok ? 0 : 1;
+}
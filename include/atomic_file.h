@@ -0,0 +1,77 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @brief 以 "写临时文件 + rename()" 的方式原子地替换一个文件
+ *
+ * 临时文件位于目标文件的同一目录, 提交时继承原文件的权限与属主
+ * (新文件则按 umask 取 0666 & ~umask), 再 rename 覆盖目标。
+ * 中途失败不会留下写了一半的目标文件。目标是符号链接时,
+ * 替换的是它指向的文件。
+ *
+ * 默认不 fsync: 成千上万个文件逐个等待落盘会让整次运行受限于磁盘刷新。
+ * 需要在掉电后也保证新内容完整时, 在提交前把 `durable` 置为 true。
+ */
+typedef struct {
+  int fd;
+  const char *target;
+  char *tmp_path;
+  /* 提交时先 fsync 临时文件; atomic_file_open 置为 false */
+  bool durable;
+} atomic_file_t;
+
+/**
+ * @brief 在 `target` 所在目录创建临时文件
+ *
+ * @param af      要初始化的句柄
+ * @param alc     用于路径等分配的 Arena
+ * @param target  最终要替换的文件路径
+ * @return true 成功, false 无法创建临时文件
+ */
+bool atomic_file_open(atomic_file_t *af, allocer_t *alc, const char *target);
+
+/**
+ * @brief 追加写入一段内存
+ */
+bool atomic_file_write(atomic_file_t *af, const void *data, size_t len);
+
+/**
+ * @brief 把 `src_fd` 中从 `offset` 开始的 `len` 字节追加到临时文件
+ *
+ * 依次尝试 copy_file_range、sendfile, 都不可用时退回 pread/write,
+ * 数据尽量不经过用户态。遇到源文件提前结束时停止。
+ */
+bool atomic_file_copy_range(atomic_file_t *af, int src_fd, off_t offset,
+                            size_t len);
+
+/**
+ * @brief 提交: 复制原文件权限 (`durable` 时再 fsync) 并 rename 覆盖目标
+ *
+ * 无论成功与否, 句柄都会被关闭。
+ */
+bool atomic_file_commit(atomic_file_t *af);
+
+/**
+ * @brief 放弃: 关闭并删除临时文件, 目标文件保持不变
+ */
+void atomic_file_abort(atomic_file_t *af);
@@ -0,0 +1,143 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+/** 默认的清单文件名 (相对于当前工作目录) */
+#define CACHE_DEFAULT_FILE ".cnote-cache"
+
+/**
+ * @brief 判断文件是否被改动过的 stat 元组
+ */
+typedef struct {
+  uint64_t size;
+  uint64_t mtime_ns;
+  uint64_t ino;
+} file_stamp_t;
+
+/**
+ * @brief 清单中的一条记录
+ *
+ * 哈希为 0 表示 "未知": 只有在 `stamp` 不变时, 之前记录的值才会保留。
+ */
+typedef struct {
+  const char *path;
+  file_stamp_t stamp;
+  /* 上次处理后文件内容的哈希 */
+  uint64_t content_hash;
+  /* 上次 clean 时使用的格式化配置的哈希 */
+  uint64_t style_hash;
+  /* 上次 license 时使用的许可证头的哈希 */
+  uint64_t license_hash;
+  /* 上次 doc 生成的页面的哈希; 没有页面时为空内容的哈希 */
+  uint64_t output_hash;
+} cache_entry_t;
+
+/**
+ * @brief `--incremental` 与 doc 使用的清单: path -> cache_entry_t
+ *
+ * 以开放寻址哈希表保存在 Arena 中。查询可以在多个线程中并发进行,
+ * 但 cache_update / cache_forget 只能在没有并发查询时由主线程调用。
+ */
+typedef struct {
+  allocer_t *alc;
+  const char *file;
+  cache_entry_t *slots;
+  size_t cap;
+  size_t count;
+  bool dirty;
+} cache_t;
+
+/**
+ * @brief 计算一段字节的 64 位哈希 (非加密, 结果从不为 0)
+ */
+uint64_t cache_hash(const void *data, size_t len);
+
+/**
+ * @brief 在 `seed` 的基础上继续哈希一段字节, 用于组合多个输入
+ */
+uint64_t cache_hash_more(uint64_t seed, const void *data, size_t len);
+
+/**
+ * @brief 从 struct stat 提取 stat 元组
+ */
+void file_stamp_from_stat(const struct stat *st, file_stamp_t *out);
+
+/**
+ * @brief 判断两个 stat 元组是否相同
+ */
+bool file_stamp_equals(const file_stamp_t *a, const file_stamp_t *b);
+
+/**
+ * @brief 读取清单; 文件不存在或格式不符时得到一个空清单
+ *
+ * @param cache (未初始化) 要填充的清单
+ * @param alc   清单及其路径字符串所在的 Arena
+ * @param file  清单文件路径
+ * @return true 成功, false 内存不足
+ */
+bool cache_load(cache_t *cache, allocer_t *alc, const char *file);
+
+/**
+ * @brief 查找 `path` 的记录
+ *
+ * @return 找到时返回记录, 否则返回 NULL
+ */
+const cache_entry_t *cache_lookup(const cache_t *cache, const char *path);
+
+/**
+ * @brief 记录 `path` 处理后的状态
+ *
+ * 哈希参数为 0 时, 若旧记录的 stat 元组与 `stamp` 相同则沿用旧值,
+ * 否则置为未知。
+ *
+ * @return true 成功, false 内存不足
+ */
+bool cache_update(cache_t *cache, const char *path, const file_stamp_t *stamp,
+                  uint64_t content_hash, uint64_t style_hash,
+                  uint64_t license_hash, uint64_t output_hash);
+
+/**
+ * @brief 使 `path` 的记录失效 (例如处理失败后)
+ */
+void cache_forget(cache_t *cache, const char *path);
+
+/**
+ * @brief 依次取出清单中的记录, 包括已失效的记录
+ *
+ * 遍历期间可以调用 cache_forget, 但不能调用 cache_update。
+ *
+ * @param iter  迭代位置, 首次调用前置 0
+ * @return 下一条记录, 没有更多时返回 NULL
+ */
+const cache_entry_t *cache_next(const cache_t *cache, size_t *iter);
+
+/**
+ * @brief 若清单有改动, 原子地写回清单文件
+ *
+ * mtime 距离写回时刻太近的记录会被标记为需要重新校验内容,
+ * 以免在同一个时间戳粒度内发生的修改被误认为未改动。
+ *
+ * @return true 成功或无需写回, false 写入失败
+ */
+bool cache_save(cache_t *cache);
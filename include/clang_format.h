@@ -0,0 +1,59 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <report.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
+#include <std/vec.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 对一组文件批量运行 `clang-format -i`
+ *
+ * 文件按顺序切分为若干批, 每批受 ARG_MAX 限制, 通过 posix_spawnp
+ * 直接启动 (不经过 shell), 最多同时运行 `max_parallel` 个进程。
+ * 失败的批次会在 stderr 上列出其状态与包含的文件。
+ *
+ * @param alc          用于临时分配的 Arena
+ * @param paths        (vec_t*) Vec<const char*>, 要格式化的文件
+ * @param style_file   (可选) .clang-format 文件路径, 为 NULL 时使用默认
+ * @param max_parallel 同时运行的 clang-format 进程数上限
+ * @return true 所有批次都成功, false 至少一个批次失败
+ */
+bool clang_format_files(allocer_t *alc, vec_t *paths, const char *style_file,
+                        size_t max_parallel);
+
+/**
+ * @brief 通过管道用 clang-format 格式化一段内存中的源码
+ *
+ * 把 `input` 写入 `clang-format --assume-filename=<assume_filename>`
+ * 的 stdin, 并把 stdout 追加到 `out`。不读写任何源文件。
+ *
+ * @param alc             用于临时分配的 Arena
+ * @param style_file      (可选) .clang-format 文件路径, 为 NULL 时使用默认
+ * @param assume_filename 用于选择语言和查找 .clang-format 的文件名
+ * @param input           要格式化的源码
+ * @param out             (已初始化) 接收格式化结果
+ * @param rep             失败原因写入的输出缓冲
+ * @return true 成功, false clang-format 无法启动或以非零状态退出
+ */
+bool clang_format_pipe(allocer_t *alc, const char *style_file,
+                       const char *assume_filename, str_slice_t input,
+                       string_t *out, report_t *rep);
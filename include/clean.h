@@ -19,6 +19,35 @@
 #include <core/mem/allocer.h>
 #include <std/vec.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 'clean' 命令的选项
+ */
+typedef struct {
+  /* (可选) .clang-format 文件路径, 为 NULL 时使用默认 */
+  const char *style_file;
+  /* 并行处理文件的工作线程数 */
+  size_t jobs;
+  /* 逐个文件经管道交给 clang-format, 只在内容变化时写一次 */
+  bool pipe;
+  /* 借助 .cnote-cache 清单跳过上次处理后未改动的文件 */
+  bool incremental;
+  /* 打印每个被排除的路径及其命中的模式 */
+  bool verbose;
+  /* 不读取 .gitignore / .ignore, 遍历所有目录 */
+  bool no_ignore;
+  /* (可选) 额外的路径列表文件, "-" 为标准输入 */
+  const char *files_from;
+  /* (可选) 只处理相对该 git 修订有改动或未跟踪的文件; 目标作为 pathspec */
+  const char *changed_since;
+  /* 只检查不写入: 列出仍需清理的文件, 有则失败 */
+  bool check;
+  /* (仅 check) 遇到第一个需要清理或出错的文件就停止 */
+  bool fail_fast;
+  /* (仅过滤模式, 可选) 交给 clang-format 的 --assume-filename */
+  const char *assume_filename;
+} clean_opts_t;
 
 /**
  * @brief 运行 'clean' 命令
@@ -29,10 +58,22 @@
  * @param alc      用于所有临时分配的 Arena
  * @param targets  (vec_t*) 指向 Vec<const char*> 的指针, 包含要处理的文件/目录
  * @param exclusions (vec_t*) 指向 Vec<const char*> 的指针,
- * 包含要跳过的路径(子字符串匹配)
- * @param style_file (可选) 指向 .clang-format 文件的路径, 如果为 NULL
- * 则使用默认
+ * 包含要跳过的路径模式 (子串, `^前缀` 或 glob, 见 exclude.h)
+ * @param opts     命令选项
  * @return bool     true 成功, false 失败
  */
 bool cnote_clean_run(allocer_t *alc, vec_t *targets, vec_t *exclusions,
-                     const char *style_file);
\ No newline at end of file
+                     const clean_opts_t *opts);
+
+/**
+ * @brief 过滤模式 (`cnote clean -`)
+ *
+ * 从标准输入读入一个缓冲区, 删除 `//` 注释后经管道交给
+ * `clang-format --assume-filename`, 结果写到标准输出,
+ * 不读写任何源文件。出错时不输出任何内容。
+ *
+ * @param alc   用于所有临时分配的 Arena
+ * @param opts  命令选项, 只使用 'style_file' 与 'assume_filename'
+ * @return bool true 成功, false 失败
+ */
+bool cnote_clean_stdin(allocer_t *alc, const clean_opts_t *opts);
@@ -18,7 +18,29 @@
 #pragma once
 
 #include <core/mem/allocer.h>
+#include <doc_index.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 'doc' 命令的选项
+ */
+typedef struct {
+  /* 并行解析/生成页面的工作线程数 */
+  size_t jobs;
+  /* 不读取 .gitignore / .ignore, 遍历所有目录 */
+  bool no_ignore;
+  /* (可选) 只重新生成相对该 git 修订有改动或未跟踪的源文件的页面 */
+  const char *changed_since;
+  /* 同时写出按前缀分片的搜索索引 (见 doc_search.h);
+   * 搜索索引已存在时总会维护它 */
+  bool search;
+  /* 源文件的文档超过该字节数时, 页面拆分为每个符号一页 (见 doc_xref.h);
+   * 0 表示从不拆分 */
+  size_t split_above;
+} doc_opts_t;
 
 /**
  * @brief 运行文档生成器 (mdBook 模式)
@@ -26,9 +48,99 @@
  * 扫描 `src_dir` (递归)，为 .c 和 .h 文件生成文档，
  * 并将所有内容按文件结构输出到 `out_dir` (例如 'docs/')。
  *
+ * 增量进行: `out_dir` 中的清单记录每个源文件的 stat 元组、内容哈希与
+ * 页面哈希, 只重新解析有改动的源文件, 其余源文件的条目取自同在 `out_dir`
+ * 中的条目索引 (见 doc_index.h)。页面之间互相链接, 因此每次都由全部条目
+ * 重新生成所有页面, 但只写出内容有变化的; 已不存在的源文件的页面被删除。
+ *
  * @param alc      用于所有操作的 Arena 分配器
  * @param src_dir  要扫描的源目录
  * @param out_dir  要写入 Markdown 文件的输出目录
+ * @param opts     命令选项
  * @return true 成功, false 失败
  */
-bool cnote_doc_run(allocer_t *alc, const char *src_dir, const char *out_dir);
\ No newline at end of file
+bool cnote_doc_run(allocer_t *alc, const char *src_dir, const char *out_dir,
+                   const doc_opts_t *opts);
+
+/**
+ * @brief 只从 `out_dir` 中的条目索引重新生成所有页面与 SUMMARY.md
+ *
+ * 不读取、也不切分任何源文件; 用于改变页面样式后重建站点。
+ * 只使用 `opts->jobs`。
+ *
+ * @param alc      用于所有操作的 Arena 分配器
+ * @param out_dir  含有索引的输出目录
+ * @param opts     命令选项
+ * @return true 成功, false 索引缺失、损坏或页面无法写入
+ */
+bool cnote_doc_render_index(allocer_t *alc, const char *out_dir,
+                            const doc_opts_t *opts);
+
+/**
+ * @brief 源文件页面的文件名 (位于 `api/` 中), 例如 `src/doc.c` -> `src_doc_c.md`
+ */
+void doc_page_name(str_slice_t relative_path, string_t *out);
+
+/**
+ * @brief 只在内容不同时写文件, 以免无谓地更新 mtime 触发站点重建
+ *
+ * @return true 内容相同或写入成功, false 无法写入
+ */
+bool doc_write_if_changed(allocer_t *alc, const char *path, str_slice_t bytes);
+
+/**
+ * @brief 文档站点的输出位置: `out_dir/SUMMARY.md` 与 `out_dir/api/`
+ */
+typedef struct {
+  const char *out_dir;
+  const char *api_out_dir;
+  /* 拆分页面的阈值, 见 doc_page_is_split; doc_site_open 置为 0 */
+  size_t split_above;
+} doc_site_t;
+
+/**
+ * @brief 创建 (若不存在) 输出目录 `out_dir` 及其 `api/` 子目录
+ *
+ * @param site     要初始化的站点
+ * @param alc      用于路径的 Arena, 须活到站点不再使用
+ * @param out_dir  输出目录
+ * @return true 成功, false 无法创建目录
+ */
+bool doc_site_open(doc_site_t *site, allocer_t *alc, const char *out_dir);
+
+/**
+ * @brief 解析一个源文件的内容, 取出其中的条目
+ *
+ * 可在多个线程中同时调用。
+ *
+ * @param alc        用于临时分配的 Arena
+ * @param entry_alc  用于条目的 Arena, 须活到 doc_site_render_all 之后
+ * @param content    源文件内容
+ * @param file       接收条目; `entries` 总不为 NULL, 相对路径由调用者填写
+ * @return true 成功, false 内存不足
+ */
+bool doc_site_parse(allocer_t *alc, allocer_t *entry_alc, str_slice_t content,
+                    doc_index_file_t *file);
+
+/**
+ * @brief 由所有源文件的条目生成互相链接的页面与 SUMMARY.md
+ *
+ * 先由全部条目建立符号表 (见 doc_xref.h), 再并行地生成各页面:
+ * 声明与 `@param`/`@return` 说明中出现的已知符号链接到定义它的页面与锚点。
+ * 超过 `site->split_above` 的源文件只生成声明的列表, 每个条目另成一页,
+ * SUMMARY.md 中这些页面嵌套在源文件之下。没有条目或不再拆分的源文件
+ * 删除以前生成的多余页面。SUMMARY.md 按相对路径的字节序排列,
+ * 结果与遍历顺序、线程数和文件系统都无关。页面与 SUMMARY.md 都只在内容
+ * 变化时写出。
+ *
+ * @param site         输出站点
+ * @param alc          用于临时分配的 Arena
+ * @param files        各源文件的条目
+ * @param count        源文件个数
+ * @param jobs         生成页面的工作线程数
+ * @param page_hashes  (可选) 接收各源文件页面的哈希, 没有页面时为空内容的哈希
+ * @return true 成功, false 有页面或 SUMMARY.md 无法写入
+ */
+bool doc_site_render_all(const doc_site_t *site, allocer_t *alc,
+                         const doc_index_file_t *files, size_t count,
+                         size_t jobs, uint64_t *page_hashes);
@@ -0,0 +1,113 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* doc 索引的文件名, 位于 out_dir 中 */
+#define DOC_INDEX_FILE ".cnote-doc-index"
+
+/**
+ * @brief 一个文档注释及其后的声明
+ */
+typedef struct {
+  str_slice_t comment;
+  str_slice_t signature;
+} doc_entry_t;
+
+/**
+ * @brief 写入索引的一个源文件
+ */
+typedef struct {
+  /* 源文件相对源目录的路径 */
+  str_slice_t relative_path;
+  /* 按出现顺序排列的条目, 没有条目的源文件不写入索引 */
+  const doc_entry_t *entries;
+  size_t count;
+} doc_index_file_t;
+
+/**
+ * @brief 按相对路径的字节序排好源文件后, 原子地写出二进制索引
+ *
+ * 格式 (整数均为小端 uint32):
+ *
+ *     头部  "CNDOCIDX" version n_files n_entries strtab_size 0 0  (32 字节)
+ *     文件  path_off path_len first_entry n_entries            (各 16 字节)
+ *     条目  signature_off signature_len comment_off comment_len (各 16 字节)
+ *     字符串表
+ *
+ * 偏移都相对字符串表开头。记录定长, 打开时只需 mmap 并校验一遍,
+ * 之后按下标直接访问, 不做任何解析或复制。
+ *
+ * @param alc    用于临时分配的 Arena
+ * @param path   索引文件路径
+ * @param files  各源文件的条目, 会被原地排序
+ * @param count  源文件个数
+ * @return true 成功, false 无法写入或超出 4 GiB 的格式上限
+ */
+bool doc_index_write(allocer_t *alc, const char *path, doc_index_file_t *files,
+                     size_t count);
+
+/**
+ * @brief 以只读 mmap 打开的索引
+ */
+typedef struct {
+  const unsigned char *base;
+  size_t size;
+  size_t n_files;
+  size_t n_entries;
+  const unsigned char *files;
+  const unsigned char *entries;
+  const char *strtab;
+} doc_index_t;
+
+/**
+ * @brief 打开并校验索引
+ *
+ * 不存在、格式或版本不符、记录越界时都返回 false, 并把 `ix` 置为空索引,
+ * 此时仍可安全地调用 doc_index_close 与各查询函数。
+ */
+bool doc_index_open(doc_index_t *ix, const char *path);
+
+/**
+ * @brief 解除映射; 之前取出的所有片段随之失效
+ */
+void doc_index_close(doc_index_t *ix);
+
+/**
+ * @brief 第 `i` 个源文件 (按相对路径排序) 的路径与条目范围
+ */
+void doc_index_file(const doc_index_t *ix, size_t i, str_slice_t *relative_path,
+                    size_t *first_entry, size_t *n_entries);
+
+/**
+ * @brief 第 `i` 个条目; 片段直接指向映射的内存
+ */
+void doc_index_entry(const doc_index_t *ix, size_t i, doc_entry_t *entry);
+
+/**
+ * @brief 二分查找源文件
+ *
+ * @param index  接收源文件下标
+ * @return true 找到, false 索引中没有该源文件
+ */
+bool doc_index_find(const doc_index_t *ix, str_slice_t relative_path,
+                    size_t *index);
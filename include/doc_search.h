@@ -0,0 +1,65 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <doc_index.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 搜索索引所在的子目录, 位于 out_dir 中 */
+#define DOC_SEARCH_DIR "search"
+/* 分片依据的词项前缀字节数 */
+#define DOC_SEARCH_PREFIX 2
+
+/**
+ * @brief 从声明中取出它定义的符号名
+ *
+ * 函数取 `(` 前的标识符, 函数指针取 `(*` 后的标识符, 宏取 `#define`
+ * 后的标识符, 其余取结尾 (`;`、`{`、`=`、`[`) 前的最后一个标识符。
+ * 例如 `typedef struct {` 这样没有名字的声明返回 false。
+ *
+ * @param signature  doc_entry_t 中的声明
+ * @param name       接收指向 `signature` 内部的符号名
+ * @return true 找到符号名, false 没有
+ */
+bool doc_entry_symbol(str_slice_t signature, str_slice_t *name);
+
+/**
+ * @brief 为所有条目写出按前缀分片的倒排索引
+ *
+ * 词项为小写的符号名及其按 `_` 切开的各段, 以及 `@brief` 中的单词;
+ * 连续的非 ASCII 字节作为一个词项。每个词项按前 DOC_SEARCH_PREFIX 个字节
+ * 的十六进制归入分片 `search/<hex>.json`, 分片内含它引用的条目与排好序的
+ * 词项, 因此查询 (包括前缀查询) 只需加载一个分片:
+ *
+ *     {"docs":[["api/page.md","title"],...],
+ *      "terms":[["term",[doc,...]],...]}
+ *
+ * `search/meta.json` 列出所有分片。内容不变的分片不重写, 多余的分片删除。
+ *
+ * @param alc          用于临时分配的 Arena
+ * @param out_dir      输出目录
+ * @param files        各源文件的条目, 应已按相对路径排好序
+ * @param count        源文件个数
+ * @param split_above  拆分页面的阈值, 决定条目链接到哪个页面 (见 doc_xref.h)
+ * @return true 成功, false 无法写入
+ */
+bool doc_search_write(allocer_t *alc, const char *out_dir,
+                      const doc_index_file_t *files, size_t count,
+                      size_t split_above);
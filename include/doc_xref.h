@@ -0,0 +1,105 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <doc_index.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 源文件的页面是否拆分为每个符号一页
+ *
+ * 以条目的注释与声明的总字节数估计页面大小, 不必先生成页面。
+ *
+ * @param file         源文件的条目
+ * @param split_above  阈值 (字节), 0 表示从不拆分
+ * @return true 总字节数超过阈值
+ */
+bool doc_page_is_split(const doc_index_file_t *file, size_t split_above);
+
+/**
+ * @brief 计算各条目所在页面相对 `api/` 的路径
+ *
+ * 不拆分时都是源文件的页面 (doc_page_name); 拆分后源文件的页面只列出
+ * 各条目的声明, 条目各自位于 `<页面名去掉 .md>/<符号名>.md`,
+ * 没有符号名的条目与同名的后续条目为 `entry-<k>.md` (k 从 1 起)。
+ *
+ * @param alc          用于路径的 Arena
+ * @param file         源文件的条目
+ * @param split_above  见 doc_page_is_split
+ * @param pages        接收 `file->count` 个路径
+ * @return true 成功, false 内存不足
+ */
+bool doc_entry_pages(allocer_t *alc, const doc_index_file_t *file,
+                     size_t split_above, str_slice_t *pages);
+
+/**
+ * @brief 符号表中的一个符号
+ */
+typedef struct {
+  /* 符号名, 同时是它在页面中的锚点 */
+  str_slice_t name;
+  /* 定义所在页面相对 `api/` 的路径 (见 doc_entry_pages) */
+  str_slice_t page;
+  /* 定义所在的源文件; 同一源文件中的重复定义保留第一个 */
+  const doc_index_file_t *file;
+  /* 作为定义的条目, 只有它在页面中带有锚点 */
+  const doc_entry_t *entry;
+  /* 头文件中的定义优先于源文件中的 */
+  bool from_header;
+  /* 同一优先级有多处定义: 不知道该链接到哪里, 查询时视为不存在 */
+  bool ambiguous;
+} doc_symbol_t;
+
+/**
+ * @brief 所有源文件中有文档的符号: name -> doc_symbol_t
+ *
+ * 以开放寻址 (线性探测) 哈希表保存在 Arena 中, 容量为 2 的幂且至少是
+ * 符号数的两倍, 每次查询的代价与符号总数无关。建好后只读,
+ * 可在多个线程中并发查询。
+ */
+typedef struct {
+  doc_symbol_t *slots;
+  size_t cap;
+} doc_symtab_t;
+
+/**
+ * @brief 由所有源文件的条目建立符号表
+ *
+ * 符号名由 doc_entry_symbol 取出; 名字与页面名都指向 `files` 中的内存
+ * 或 `alc`, 须在符号表使用期间保持有效。结果与 `files` 的顺序无关。
+ *
+ * @param tab          要初始化的符号表
+ * @param alc          用于表与页面名的 Arena
+ * @param files        各源文件的条目
+ * @param count        源文件个数
+ * @param split_above  见 doc_page_is_split
+ * @return true 成功, false 内存不足
+ */
+bool doc_symtab_build(doc_symtab_t *tab, allocer_t *alc,
+                      const doc_index_file_t *files, size_t count,
+                      size_t split_above);
+
+/**
+ * @brief 查找符号
+ *
+ * @return 唯一的定义, 不存在或有歧义时返回 NULL
+ */
+const doc_symbol_t *doc_symtab_lookup(const doc_symtab_t *tab,
+                                      str_slice_t name);
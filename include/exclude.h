@@ -0,0 +1,72 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <std/vec.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 预编译的 `--exclude` 模式集合
+ *
+ * 每个模式按写法归入三类:
+ * - `^prefix`: 锚定前缀, 路径以 `prefix` 开头时匹配;
+ * - 含 `*`, `?` 或 `[` 的 glob: 用 fnmatch 匹配整个路径 (`*` 可跨越 `/`),
+ *   不含 `/` 的 glob 还会匹配路径的最后一段;
+ * - 其余为子串模式 (与旧行为一致), 全部编译进一个 Aho-Corasick 自动机,
+ *   每条路径只需扫描一遍, 与模式数量无关。
+ */
+typedef struct {
+  vec_t patterns;
+  /* Aho-Corasick: 按字节类压缩的完整转移表 */
+  uint8_t byte_class[256];
+  size_t n_classes;
+  int32_t *delta;
+  /* 每个状态可以报告的模式下标, -1 表示无 */
+  int32_t *out;
+  size_t n_states;
+  /* 锚定前缀与 glob 模式在 `patterns` 中的下标 */
+  vec_t prefixes;
+  vec_t globs;
+} exclude_set_t;
+
+/**
+ * @brief 编译一组排除模式
+ *
+ * @param set       要初始化的集合
+ * @param alc       用于存放自动机与模式表的 Arena
+ * @param patterns  (vec_t*) Vec<const char*>, 原始模式; 字符串须比集合活得长
+ * @return true 成功, false 内存不足
+ */
+bool exclude_set_init(exclude_set_t *set, allocer_t *alc, vec_t *patterns);
+
+/**
+ * @brief 判断路径是否被排除
+ *
+ * 目录按 `path/` 的形式匹配, 因此 `vendor/` 这样的模式会在打开
+ * vendor 目录之前就命中, 整棵子树被剪掉。
+ *
+ * @param set     已编译的集合
+ * @param path    要检查的路径
+ * @param is_dir  `path` 是否为目录
+ * @return 命中的原始模式, 未命中时返回 NULL
+ */
+const char *exclude_match(const exclude_set_t *set, str_slice_t path,
+                          bool is_dir);
@@ -0,0 +1,41 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <path_list.h>
+#include <std/vec.h>
+#include <stdbool.h>
+
+/**
+ * @brief 列出相对 `rev` 有改动或未被跟踪的文件 (`--changed-since`)
+ *
+ * 依次运行 `git diff --name-only -z --relative --diff-filter=d <rev>`
+ * 与 `git ls-files -z --others --exclude-standard`, 边读边把路径交给回调。
+ * 已删除的文件不会出现在结果中。
+ *
+ * @param alc        用于临时分配的 Arena
+ * @param rev        作为比较基准的修订 (不能以 `-` 开头)
+ * @param dir        (可选) 在该目录中运行 git (`git -C`), 路径相对于它;
+ *                   为 NULL 时相对当前目录
+ * @param pathspecs  (可选, vec_t*) Vec<const char*>, 只列出这些路径之下的文件
+ * @param fn         对每条路径调用的回调
+ * @param ctx        传给回调的上下文
+ * @return true 成功, false git 无法运行或以非零状态退出 (例如修订不存在)
+ */
+bool git_changed_files(allocer_t *alc, const char *rev, const char *dir,
+                       vec_t *pathspecs, path_list_fn_t fn, void *ctx);
@@ -0,0 +1,105 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
+#include <std/vec.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 一条 gitignore 规则
+ *
+ * 已去掉前导 `!`/`/` 与结尾的 `/`, `pattern` 不以 NUL 结尾。
+ */
+typedef struct {
+  const char *pattern;
+  size_t len;
+  bool negate;
+  bool dir_only;
+  /* 含有 `/` 的规则相对所在目录匹配完整路径, 否则只匹配最后一段 */
+  bool anchored;
+} ignore_rule_t;
+
+/**
+ * @brief 一个目录 (或其祖先) 的全部规则
+ */
+typedef struct {
+  vec_t rules;
+  /* 该目录相对仓库顶层 (无仓库时为遍历起点) 的路径长度, 含结尾 `/` */
+  size_t base_len;
+} ignore_level_t;
+
+/**
+ * @brief 遍历过程中逐层压入/弹出的 .gitignore 与 .ignore 规则栈
+ *
+ * 较深目录的规则优先于较浅目录; 同一目录中 .ignore 优先于 .gitignore,
+ * 同一文件中靠后的规则优先。遍历起点位于 git 仓库内时, 还会加载
+ * 起点与仓库顶层之间各级目录的 .gitignore 以及 .git/info/exclude。
+ */
+typedef struct {
+  allocer_t *alc;
+  ignore_level_t *levels;
+  size_t depth;
+  size_t cap;
+  /* 遍历起点相对仓库顶层的路径, 非空时以 `/` 结尾 */
+  string_t root_prefix;
+  /* 起点之上的层数; 匹配这些层时需要拼接 root_prefix */
+  size_t n_parents;
+  string_t scratch;
+} ignore_stack_t;
+
+/**
+ * @brief 初始化规则栈, 并加载 `root` 之上各级目录的规则
+ *
+ * @param st    要初始化的规则栈
+ * @param alc   规则与缓冲所在的 Arena
+ * @param root  遍历起点目录
+ * @return true 成功, false 内存不足
+ */
+bool ignore_stack_init(ignore_stack_t *st, allocer_t *alc, const char *root);
+
+/**
+ * @brief 进入一个目录: 读取其中的 .gitignore 与 .ignore 并压栈
+ *
+ * 即使目录中没有规则文件也会压入一个空层, 以便与 ignore_stack_pop 配对。
+ *
+ * @param st       规则栈
+ * @param dir_fd   已打开的目录
+ * @param rel_dir  目录相对遍历起点的路径, 非空时以 `/` 结尾
+ * @return true 成功, false 内存不足
+ */
+bool ignore_stack_push_dir(ignore_stack_t *st, int dir_fd,
+                           str_slice_t rel_dir);
+
+/**
+ * @brief 离开最近进入的目录
+ */
+void ignore_stack_pop(ignore_stack_t *st);
+
+/**
+ * @brief 判断一个目录项是否被忽略
+ *
+ * @param st        规则栈
+ * @param rel_path  目录项相对遍历起点的路径
+ * @param is_dir    是否为目录 (只对目录生效的规则需要)
+ * @return true 被忽略
+ */
+bool ignore_stack_match(ignore_stack_t *st, str_slice_t rel_path,
+                        bool is_dir);
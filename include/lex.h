@@ -0,0 +1,126 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <scan.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 不小于该大小的文件改为按块流式处理, 见 lex_stream_fd */
+#define LEX_STREAM_MIN_SIZE ((size_t)16 << 20)
+/* 流式处理时每次读入的字节数 */
+#define LEX_STREAM_CHUNK ((size_t)1 << 20)
+
+/**
+ * @brief 词法片段的种类
+ */
+typedef enum {
+  /* 普通代码 (含空白与换行) */
+  LEX_CODE,
+  /* 预处理指令中注释与字面量之外的部分, 含续行与结尾的换行 */
+  LEX_PREPROC,
+  /* `// ...`, 不含结尾的换行; 反斜杠续行属于注释 */
+  LEX_LINE_COMMENT,
+  /* 含两端定界符的块注释 */
+  LEX_BLOCK_COMMENT,
+  /* 含两端引号的字符串字面量 */
+  LEX_STRING,
+  /* 含两端引号的字符字面量 */
+  LEX_CHAR,
+} lex_kind_t;
+
+/**
+ * @brief 一个词法片段
+ *
+ * `text` 直接指向输入缓冲区, 不做任何复制。所有片段按顺序首尾相接,
+ * 拼起来就是原始输入。
+ */
+typedef struct {
+  lex_kind_t kind;
+  str_slice_t text;
+  /* 块注释与字面量是否遇到了结束定界符; 其他种类总为 true。
+   * 字面量在未转义的换行处结束 (不含换行), 此时为 false。 */
+  bool terminated;
+} lex_token_t;
+
+/**
+ * @brief 流式 C 词法分析器
+ *
+ * 只区分注释、字面量、预处理指令与其余代码, 不切分标识符等记号。
+ * 普通代码借助 scan_fn_t 整段跳过, 只在 `/`、引号等特殊字节处停下。
+ */
+typedef struct {
+  scan_fn_t find;
+  const char *start;
+  const char *p;
+  const char *end;
+  bool in_directive;
+  /* (流式) `end` 之后还有输入, 跨过 `end` 的片段要等补齐后再切分 */
+  bool more;
+  /* `start` 之前直到行首是否只有空白; 整段输入时总为 true */
+  bool line_blank;
+  scan_set_t code_set;
+  scan_set_t directive_set;
+  scan_set_t string_set;
+  scan_set_t char_set;
+} lexer_t;
+
+/**
+ * @brief 在 `src` 上初始化词法分析器
+ *
+ * @param lx    要初始化的分析器
+ * @param find  查找特殊字节的实现, 通常为 scan_select()
+ * @param src   要切分的源码, 须在使用期间保持有效
+ */
+void lexer_init(lexer_t *lx, scan_fn_t find, str_slice_t src);
+
+/**
+ * @brief 取出下一个片段
+ *
+ * @return true 取到一个非空片段, false 输入已结束
+ */
+bool lexer_next(lexer_t *lx, lex_token_t *tok);
+
+/**
+ * @brief 接收流式切分出的片段
+ *
+ * `tok->text` 指向内部缓冲区, 只在本次调用期间有效。
+ *
+ * @return true 继续, false 中止切分
+ */
+typedef bool (*lex_sink_fn)(void *ctx, const lex_token_t *tok);
+
+/**
+ * @brief 按块读取 `fd` 并流式切分, 每个片段交给 `sink`
+ *
+ * 每次读入 `chunk` 字节; 在块尾被截断的片段连同少量回看上下文搬到缓冲区
+ * 开头, 与下一块拼接后重新切分。普通代码与预处理指令在换行处切开, 因此
+ * 内存占用约为 `chunk` 加上最长的一个注释、字面量或代码行, 与文件大小无关。
+ * 切出的片段种类与整段切分相同, 只是代码片段可能在换行后多断开一次。
+ *
+ * @param alc    用于缓冲区的 Arena
+ * @param find   查找特殊字节的实现, 通常为 scan_select()
+ * @param fd     要读取的文件描述符
+ * @param chunk  每次读入的字节数, 通常为 LEX_STREAM_CHUNK
+ * @param sink   片段回调
+ * @param ctx    传给 `sink` 的上下文
+ * @return true 成功, false 读取失败、内存不足或 `sink` 中止
+ */
+bool lex_stream_fd(allocer_t *alc, scan_fn_t find, int fd, size_t chunk,
+                   lex_sink_fn sink, void *ctx);
@@ -17,8 +17,35 @@
 #pragma once
 
 #include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
 #include <std/vec.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 'license' 命令的选项
+ */
+typedef struct {
+  /* (必需) 指向包含许可证原文的文本文件路径 */
+  const char *license_file;
+  /* 并行处理文件的工作线程数 */
+  size_t jobs;
+  /* 借助 .cnote-cache 清单跳过上次处理后未改动的文件 */
+  bool incremental;
+  /* 打印每个被排除的路径及其命中的模式 */
+  bool verbose;
+  /* 不读取 .gitignore / .ignore, 遍历所有目录 */
+  bool no_ignore;
+  /* (可选) 额外的路径列表文件, "-" 为标准输入 */
+  const char *files_from;
+  /* (可选) 只处理相对该 git 修订有改动或未跟踪的文件; 目标作为 pathspec */
+  const char *changed_since;
+  /* 只检查不写入: 列出缺少或过期许可证头的文件, 有则失败 */
+  bool check;
+  /* (仅 check) 遇到第一个不合格或出错的文件就停止 */
+  bool fail_fast;
+} license_opts_t;
 
 /**
  * @brief 运行 'license' 命令
@@ -28,9 +55,61 @@
  *
  * @param alc      用于所有临时分配的 Arena
  * @param targets  (vec_t*) 指向 Vec<const char*> 的指针, 包含要处理的文件/目录
- * @param exclusions (vec_t*) 指向 Vec<const char*> 的指针, 包含要跳过的路径
- * @param license_file (必需) 指向包含许可证原文的文本文件路径
+ * @param exclusions (vec_t*) 指向 Vec<const char*> 的指针,
+ * 包含要跳过的路径模式 (子串, `^前缀` 或 glob, 见 exclude.h)
+ * @param opts     命令选项
  * @return bool     true 成功, false 失败
  */
 bool cnote_license_run(allocer_t *alc, vec_t *targets, vec_t *exclusions,
-                       const char *license_file);
\ No newline at end of file
+                       const license_opts_t *opts);
+
+/**
+ * @brief 过滤模式 (`cnote license -f LICENSE -`)
+ *
+ * 从标准输入读入一个缓冲区, 应用 'license_file' 中的许可证头后
+ * 写到标准输出, 不读写任何源文件。出错时不输出任何内容。
+ *
+ * @param alc   用于所有临时分配的 Arena
+ * @param opts  命令选项, 只使用 'license_file'
+ * @return bool true 成功, false 失败
+ */
+bool cnote_license_stdin(allocer_t *alc, const license_opts_t *opts);
+
+/**
+ * @brief 读取许可证原文, 生成要写入文件开头的注释块
+ *
+ * @param alc           用于所有临时分配的 Arena
+ * @param license_file  许可证原文的路径
+ * @param header        (未初始化) 接收注释块
+ * @return bool true 成功, false 无法读取 (已打印原因)
+ */
+bool license_header_load(allocer_t *alc, const char *license_file,
+                         string_t *header);
+
+/**
+ * @brief 内存中一段源码的许可证头状态
+ */
+typedef enum {
+  /* 已以当前的许可证头开头 */
+  LICENSE_PRESENT,
+  /* 开头没有块注释 */
+  LICENSE_MISSING,
+  /* 开头的块注释不是当前的许可证头, 将被替换 */
+  LICENSE_OUTDATED,
+  /* 开头的块注释没有闭合 */
+  LICENSE_MALFORMED,
+} license_status_t;
+
+/**
+ * @brief 检查 `content` 的许可证头, 不做任何修改
+ *
+ * 应用许可证头的结果为 `header` + `content[body_offset..]`
+ * (状态为 LICENSE_MISSING 或 LICENSE_OUTDATED 时)。
+ *
+ * @param header       license_header_load 生成的注释块
+ * @param content      源码
+ * @param body_offset  接收正文 (旧注释与其后空白之后) 的起始偏移
+ * @return 许可证头状态
+ */
+license_status_t license_check_buffer(str_slice_t header, str_slice_t content,
+                                      size_t *body_offset);
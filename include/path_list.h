@@ -0,0 +1,53 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <stdbool.h>
+
+/**
+ * @brief 读取路径列表时对每条路径调用的回调
+ *
+ * @param path  以 NUL 结尾的路径, 只在回调期间有效
+ * @return false 停止读取
+ */
+typedef bool (*path_list_fn_t)(void *ctx, const char *path);
+
+/**
+ * @brief 边读边处理一个路径列表文件 (`--files-from`)
+ *
+ * 按块读取, 每解析出一条路径就立即交给回调, 不必等整个列表读完,
+ * 因此可以直接接在 `git diff --name-only -z` 这样的管道之后。
+ * 分隔符由最先出现的 NUL 或换行决定, 与数据如何分块到达无关:
+ * 先遇到 NUL 时按 NUL 分隔, 否则按行分隔 (忽略空行和行尾的 `\r`)。
+ *
+ * @param alc     用于缓冲的 Arena
+ * @param source  列表文件路径, "-" 表示标准输入
+ * @param fn      对每条路径调用的回调
+ * @param ctx     传给回调的上下文
+ * @return true 读完整个列表, false 无法打开/读取, 或回调要求停止
+ */
+bool path_list_read(allocer_t *alc, const char *source, path_list_fn_t fn,
+                    void *ctx);
+
+/**
+ * @brief 同 path_list_read, 但从已打开的 `fd` 读取 (不关闭它)
+ *
+ * @param name  出错时用于提示的名字
+ */
+bool path_list_read_fd(allocer_t *alc, int fd, const char *name,
+                       path_list_fn_t fn, void *ctx);
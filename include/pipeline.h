@@ -0,0 +1,78 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/vec.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief 流水线中的步骤, 总是按 license → clean → doc 的顺序执行
+ */
+typedef enum {
+  PIPELINE_LICENSE = 1 << 0,
+  PIPELINE_CLEAN = 1 << 1,
+  PIPELINE_DOC = 1 << 2,
+  PIPELINE_ALL = PIPELINE_LICENSE | PIPELINE_CLEAN | PIPELINE_DOC,
+} pipeline_step_t;
+
+/**
+ * @brief 'all' 命令的选项
+ */
+typedef struct {
+  /* pipeline_step_t 的按位或 */
+  unsigned steps;
+  /* (license 步骤必需) 许可证原文的路径 */
+  const char *license_file;
+  /* (可选) .clang-format 文件路径, 为 NULL 时使用默认 */
+  const char *style_file;
+  /* 并行处理文件的工作线程数 */
+  size_t jobs;
+  /* 打印每个被排除的路径及其命中的模式 */
+  bool verbose;
+  /* 不读取 .gitignore / .ignore, 遍历所有目录 */
+  bool no_ignore;
+  /* (仅 doc 步骤) 拆分页面的阈值, 见 doc_opts_t */
+  size_t split_above;
+} pipeline_opts_t;
+
+/**
+ * @brief 解析 `--pipeline` 的参数, 例如 "license,clean,doc"
+ *
+ * @param spec   逗号分隔的步骤名
+ * @param steps  接收 pipeline_step_t 的按位或
+ * @return true 成功, false 有未知或空的步骤名 (已打印原因)
+ */
+bool pipeline_parse_steps(const char *spec, unsigned *steps);
+
+/**
+ * @brief 运行 'all' 命令: 一次遍历完成 license、clean 与 doc
+ *
+ * 每个文件只读一次: 在内存中应用许可证头, 删除 `//` 注释并经管道
+ * 交给 clang-format, 内容有变化时写回一次, 再从最终内容生成文档页面。
+ *
+ * @param alc         用于所有临时分配的 Arena
+ * @param src_dir     要处理的源目录
+ * @param out_dir     (doc 步骤必需) 文档输出目录
+ * @param exclusions  (vec_t*) Vec<const char*>, 要跳过的路径模式
+ * @param opts        命令选项
+ * @return bool       true 成功, false 失败
+ */
+bool cnote_pipeline_run(allocer_t *alc, const char *src_dir,
+                        const char *out_dir, vec_t *exclusions,
+                        const pipeline_opts_t *opts);
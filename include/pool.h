@@ -0,0 +1,151 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <report.h>
+#include <std/allocer/bump/bump.h>
+#include <std/vec.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct job_pool job_pool_t;
+typedef struct job_slot job_slot_t;
+
+/**
+ * @brief 一个工作线程
+ *
+ * 每个工作线程拥有两个独立的 Arena, 任务函数只能用它们分配内存:
+ * `scratch` 在每个任务结束后整体释放, 用于文件内容等临时数据;
+ * `alc` 保留到 job_pool_destroy, 只用于必须活过任务的少量结果。
+ * 这样峰值内存只与同时处理的文件有关, 而与文件总数无关。
+ * `id` 在 [0, n_workers) 之间, 可用于索引调用方的每线程状态。
+ */
+typedef struct {
+  job_pool_t *pool;
+  size_t id;
+  bump_t arena;
+  allocer_t alc;
+  bump_t scratch_arena;
+  allocer_t scratch;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  job_slot_t **ring;
+  size_t head;
+  size_t count;
+  size_t cap;
+} job_worker_t;
+
+/**
+ * @brief 任务函数
+ *
+ * @param ctx     job_pool_init 传入的共享上下文 (只读)
+ * @param worker  执行该任务的工作线程
+ * @param job     job_pool_submit 传入的任务
+ * @param rep     该任务的输出缓冲, 按提交顺序刷出
+ * @return true 成功, false 失败 (计入 job_pool_wait 的结果)
+ */
+typedef bool (*job_fn_t)(void *ctx, job_worker_t *worker, void *job,
+                         report_t *rep);
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 任务按轮转分发到各线程的双端队列, 线程从自己的队首取任务,
+ * 空闲时从其他线程的队尾窃取。任务输出按提交顺序刷出。
+ */
+struct job_pool {
+  allocer_t *alc;
+  job_fn_t fn;
+  void *ctx;
+  job_worker_t *workers;
+  size_t n_workers;
+  size_t n_threads;
+  size_t next_worker;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  size_t queued;
+  bool closing;
+  bool cancelled;
+
+  pthread_mutex_t out_lock;
+  vec_t slots;
+  size_t flushed;
+  size_t failed;
+};
+
+/**
+ * @brief 返回默认线程数 (在线 CPU 数, 至少为 1)
+ */
+size_t job_pool_default_workers(void);
+
+/**
+ * @brief 初始化线程池并启动工作线程
+ *
+ * `n_workers` 为 1 时不创建线程, 任务在 job_pool_submit 中直接执行。
+ *
+ * @param pool       要初始化的线程池
+ * @param alc        提交线程使用的 Arena
+ * @param n_workers  工作线程数
+ * @param fn         任务函数
+ * @param ctx        传给任务函数的共享上下文
+ * @return true 成功, false 失败
+ */
+bool job_pool_init(job_pool_t *pool, allocer_t *alc, size_t n_workers,
+                   job_fn_t fn, void *ctx);
+
+/**
+ * @brief 提交一个任务 (只能在调用 job_pool_init 的线程上调用)
+ */
+bool job_pool_submit(job_pool_t *pool, void *job);
+
+/**
+ * @brief 插入一条按提交顺序输出的消息 (例如遍历时的警告)
+ */
+void job_pool_note(job_pool_t *pool, FILE *stream, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief 取消尚未开始的任务 (可在任务函数中调用)
+ *
+ * 已经在运行的任务照常结束; 之后取出的任务不再调用任务函数,
+ * 也不计为失败。用于 `--fail-fast` 在第一个失败后停止。
+ */
+void job_pool_cancel(job_pool_t *pool);
+
+/**
+ * @brief 判断 job_pool_cancel 是否已被调用
+ */
+bool job_pool_cancelled(job_pool_t *pool);
+
+/**
+ * @brief 等待所有任务完成并刷出全部输出
+ *
+ * @return true 所有任务都成功, false 至少一个任务失败
+ */
+bool job_pool_wait(job_pool_t *pool);
+
+/**
+ * @brief 释放工作线程的 Arena
+ *
+ * 任务在工作线程 Arena 中产生的结果在此之前一直有效。
+ */
+void job_pool_destroy(job_pool_t *pool);
@@ -0,0 +1,59 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/string.h>
+#include <stdbool.h>
+
+/**
+ * @brief 单个任务的输出缓冲
+ *
+ * 工作线程不直接写 stdout/stderr, 而是把消息先写入各自任务的
+ * report_t, 再由线程池按提交顺序统一刷出, 保证输出与线程调度无关。
+ */
+typedef struct {
+  allocer_t *alc;
+  string_t out;
+  string_t err;
+} report_t;
+
+/**
+ * @brief 初始化一个空的输出缓冲
+ *
+ * @param rep  要初始化的缓冲
+ * @param alc  缓冲使用的 Arena (必须只被当前线程使用)
+ * @return true 成功, false 内存不足
+ */
+bool report_init(report_t *rep, allocer_t *alc);
+
+/**
+ * @brief 追加一条格式化消息, 稍后写到 stdout
+ */
+void report_out(report_t *rep, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief 追加一条格式化消息, 稍后写到 stderr
+ */
+void report_err(report_t *rep, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief 把缓冲内容写到 stdout/stderr 并清空
+ */
+void report_flush(report_t *rep);
@@ -0,0 +1,61 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCAN_MAX_NEEDLES 4
+
+/**
+ * @brief 一组要查找的字节 (最多 SCAN_MAX_NEEDLES 个)
+ */
+typedef struct {
+  size_t n;
+  char chars[SCAN_MAX_NEEDLES];
+  bool member[256];
+} scan_set_t;
+
+/**
+ * @brief 查找函数: 返回 [p, end) 中第一个属于 `set` 的字节, 没有则返回 end
+ */
+typedef const char *(*scan_fn_t)(const char *p, const char *end,
+                                 const scan_set_t *set);
+
+/**
+ * @brief 用 C 字符串中的字节初始化一个查找集合
+ */
+void scan_set_init(scan_set_t *set, const char *chars);
+
+/**
+ * @brief 返回运行时选出的最快实现 (AVX2 > SSE2 > 标量)
+ *
+ * 可用环境变量 `CNOTE_SCAN=scalar|sse2|avx2` 强制指定实现。
+ */
+scan_fn_t scan_select(void);
+
+/**
+ * @brief 按名字获取某个实现, 当前 CPU 不支持时返回 NULL
+ *
+ * @param name  "scalar", "sse2" 或 "avx2"
+ */
+scan_fn_t scan_impl(const char *name);
+
+/**
+ * @brief 返回 scan_select() 所选实现的名字
+ */
+const char *scan_impl_name(void);
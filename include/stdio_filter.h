@@ -0,0 +1,37 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+
+/**
+ * @brief 把标准输入全部读入内存 (过滤模式 `cnote clean -`)
+ *
+ * @param alc  用于缓冲区的 Arena
+ * @param out  成功时指向读到的内容, 以 NUL 结尾
+ * @return true 成功, false 读取出错 (已打印原因)
+ */
+bool stdio_filter_read(allocer_t *alc, str_slice_t *out);
+
+/**
+ * @brief 把 `data` 完整写到标准输出, 处理短写与 EINTR
+ *
+ * @return true 成功, false 写入出错 (已打印原因)
+ */
+bool stdio_filter_write(str_slice_t data);
@@ -0,0 +1,51 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic_file.h>
+#include <core/mem/allocer.h>
+#include <scan.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
+
+/**
+ * @brief 删除 C 源码中的 `//` 行注释
+ *
+ * 保留块注释、字符串和字符字面量中的内容。源码由 lexer_t 切分,
+ * 两个行注释之间的内容整段追加到 `out`。以反斜杠续行的行注释整体删除。
+ *
+ * @param find  查找特殊字节的实现, 通常为 scan_select()
+ * @param src   原始源码
+ * @param out   (已初始化) 接收删除注释后的源码
+ */
+void strip_line_comments(scan_fn_t find, str_slice_t src, string_t *out);
+
+/**
+ * @brief strip_line_comments 的流式版本, 用于很大的文件
+ *
+ * 经 lex_stream_fd 按块读取 `fd`, 结果攒满一块就追加写入 `out`,
+ * 内存占用与文件大小无关。
+ *
+ * @param alc      用于缓冲区的 Arena
+ * @param find     查找特殊字节的实现, 通常为 scan_select()
+ * @param fd       要读取的源文件
+ * @param out      (可选) 接收结果的临时文件, 为 NULL 时只统计
+ * @param removed  接收删除的行注释个数; 为 0 时结果与原文相同
+ * @return true 成功, false 读取或写入失败
+ */
+bool strip_line_comments_fd(allocer_t *alc, scan_fn_t find, int fd,
+                            atomic_file_t *out, size_t *removed);
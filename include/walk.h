@@ -0,0 +1,76 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <core/mem/allocer.h>
+#include <std/string/str_slice.h>
+#include <stdbool.h>
+
+/**
+ * @brief walk_tree 的选项位
+ */
+typedef enum {
+  WALK_NO_FLAGS = 0,
+  /* 按 .gitignore / .ignore 规则跳过目录项, 并跳过 .git 目录 */
+  WALK_HONOR_IGNORE = 1 << 0,
+} walk_flags_t;
+
+typedef enum {
+  WALK_FILE,
+  WALK_DIR,
+  WALK_OTHER,
+  WALK_ERR_OPEN_DIR,
+  WALK_ERR_STAT,
+} walk_kind_t;
+
+/**
+ * @brief 遍历时交给回调的一个目录项
+ *
+ * `path` 与 `name` 指向遍历器内部的路径缓冲 (以 NUL 结尾),
+ * 只在回调期间有效; 需要保留时请自行复制。
+ */
+typedef struct {
+  walk_kind_t kind;
+  str_slice_t path;
+  str_slice_t name;
+} walk_entry_t;
+
+/**
+ * @brief 遍历回调
+ *
+ * @return 对 WALK_DIR 返回 false 表示不进入该目录; 其他类型忽略返回值
+ */
+typedef bool (*walk_fn_t)(void *ctx, const walk_entry_t *entry);
+
+/**
+ * @brief 以先序深度优先遍历 `root` 下的所有目录项
+ *
+ * 使用显式栈而非递归, 子目录通过 openat 相对父目录打开;
+ * dirent.d_type 已知时不调用 stat, 只有符号链接和未知类型才 fstatat。
+ * 所有路径共用一个缓冲, 每一项只追加名字, 不重新拼接父路径。
+ * 带 WALK_HONOR_IGNORE 时, 被忽略的目录项不会交给回调,
+ * 被忽略的目录也不会被打开。
+ *
+ * @param alc   用于路径缓冲和目录栈的 Arena
+ * @param root  要遍历的目录
+ * @param flags walk_flags_t 的按位或
+ * @param fn    对每个目录项调用的回调
+ * @param ctx   传给回调的上下文
+ * @return true 成功, false 无法打开 `root` 或内存不足
+ */
+bool walk_tree(allocer_t *alc, const char *root, unsigned flags, walk_fn_t fn,
+               void *ctx);
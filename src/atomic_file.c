@@ -0,0 +1,205 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <atomic_file.h>
+
+#include <core/mem/layout.h>
+#include <std/string/string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief (辅助) 复制一个 C 字符串到 Arena
+ */
+static inline char *allocer_strdup(allocer_t *alc, const char *s) {
+  size_t len = strlen(s);
+  layout_t layout = layout_of_array(char, len + 1);
+  char *new_s = allocer_alloc(alc, layout);
+  if (new_s) {
+    memcpy(new_s, s, len + 1);
+  }
+  return new_s;
+}
+
+/* 进程启动时的 umask; 运行中读取 umask 必须临时改写它, 与工作线程冲突 */
+static mode_t startup_umask = 022;
+
+__attribute__((constructor)) static void read_startup_umask(void) {
+  startup_umask = umask(022);
+  umask(startup_umask);
+}
+
+bool atomic_file_open(atomic_file_t *af, allocer_t *alc, const char *target) {
+  af->fd = -1;
+  af->tmp_path = NULL;
+  af->target = target;
+  af->durable = false;
+
+  struct stat lst;
+  if (lstat(target, &lst) == 0 && S_ISLNK(lst.st_mode)) {
+    char *resolved = realpath(target, NULL);
+    if (!resolved)
+      return false;
+    af->target = allocer_strdup(alc, resolved);
+    free(resolved);
+    if (!af->target)
+      return false;
+  }
+
+  const char *slash = strrchr(af->target, '/');
+  str_slice_t dir = {.ptr = af->target,
+                     .len = slash ? (size_t)(slash - af->target + 1) : 0};
+  const char *base = slash ? slash + 1 : af->target;
+
+  string_t tmp;
+  if (!string_init(&tmp, alc, dir.len + strlen(base) + 16))
+    return false;
+  string_append_slice(&tmp, dir);
+  string_push(&tmp, '.');
+  string_append_cstr(&tmp, base);
+  string_append_cstr(&tmp, ".cnote-XXXXXX");
+
+  af->tmp_path = allocer_strdup(alc, string_as_cstr(&tmp));
+  string_destroy(&tmp);
+  if (!af->tmp_path)
+    return false;
+
+  af->fd = mkostemp(af->tmp_path, O_CLOEXEC);
+  return af->fd >= 0;
+}
+
+bool atomic_file_write(atomic_file_t *af, const void *data, size_t len) {
+  const char *p = data;
+  while (len > 0) {
+    ssize_t n = write(af->fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+static bool is_unsupported(int err) {
+  return err == EXDEV || err == ENOSYS || err == EINVAL ||
+         err == EOPNOTSUPP || err == EBADF;
+}
+
+bool atomic_file_copy_range(atomic_file_t *af, int src_fd, off_t offset,
+                            size_t len) {
+  bool eof = false;
+
+  while (len > 0 && !eof) {
+    ssize_t n = copy_file_range(src_fd, &offset, af->fd, NULL, len, 0);
+    if (n > 0) {
+      len -= (size_t)n;
+    } else if (n == 0) {
+      eof = true;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (is_unsupported(errno)) {
+      break;
+    } else {
+      return false;
+    }
+  }
+
+  while (len > 0 && !eof) {
+    ssize_t n = sendfile(af->fd, src_fd, &offset, len);
+    if (n > 0) {
+      len -= (size_t)n;
+    } else if (n == 0) {
+      eof = true;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (is_unsupported(errno)) {
+      break;
+    } else {
+      return false;
+    }
+  }
+
+  char buf[64 * 1024];
+  while (len > 0 && !eof) {
+    ssize_t n = pread(src_fd, buf, len < sizeof(buf) ? len : sizeof(buf),
+                      offset);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    if (n == 0) {
+      eof = true;
+      break;
+    }
+    if (!atomic_file_write(af, buf, (size_t)n))
+      return false;
+    offset += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+bool atomic_file_commit(atomic_file_t *af) {
+  struct stat st;
+  if (stat(af->target, &st) == 0) {
+    /* 非属主运行时 fchown 会失败, 此时只保留权限 */
+    int ignored = fchown(af->fd, st.st_uid, st.st_gid);
+    (void)ignored;
+    fchmod(af->fd, st.st_mode & 07777);
+  } else {
+    /* 新文件: 不保留 mkostemp 的 0600, 与普通创建的文件一致 */
+    fchmod(af->fd, 0666 & ~startup_umask);
+  }
+
+  if (af->durable && fsync(af->fd) != 0) {
+    atomic_file_abort(af);
+    return false;
+  }
+  if (close(af->fd) != 0) {
+    af->fd = -1;
+    atomic_file_abort(af);
+    return false;
+  }
+  af->fd = -1;
+
+  if (rename(af->tmp_path, af->target) != 0) {
+    atomic_file_abort(af);
+    return false;
+  }
+  return true;
+}
+
+void atomic_file_abort(atomic_file_t *af) {
+  if (af->fd >= 0) {
+    close(af->fd);
+    af->fd = -1;
+  }
+  if (af->tmp_path)
+    unlink(af->tmp_path);
+}
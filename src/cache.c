@@ -0,0 +1,338 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <atomic_file.h>
+#include <cache.h>
+
+#include <core/mem/layout.h>
+#include <std/io/file.h>
+#include <std/string/string.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "cnote-cache 2\n"
+#define CACHE_MIN_CAP 64
+#define CACHE_RACY_WINDOW_NS (2ULL * 1000000000ULL)
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_finish(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t cache_hash_more(uint64_t seed, const void *data, size_t len) {
+  const unsigned char *p = data;
+  uint64_t h = seed ^ ((uint64_t)len * HASH_PRIME_1);
+
+  while (len >= 8) {
+    uint64_t k;
+    memcpy(&k, p, 8);
+    h = rotl64(h ^ (k * HASH_PRIME_2), 31) * HASH_PRIME_1;
+    p += 8;
+    len -= 8;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, p, len);
+  h = rotl64(h ^ (tail * HASH_PRIME_2), 31) * HASH_PRIME_1;
+
+  h = hash_finish(h);
+  return h ? h : 1;
+}
+
+uint64_t cache_hash(const void *data, size_t len) {
+  return cache_hash_more(0, data, len);
+}
+
+void file_stamp_from_stat(const struct stat *st, file_stamp_t *out) {
+  out->size = (uint64_t)st->st_size;
+  out->mtime_ns = (uint64_t)st->st_mtim.tv_sec * 1000000000ULL +
+                  (uint64_t)st->st_mtim.tv_nsec;
+  out->ino = (uint64_t)st->st_ino;
+}
+
+bool file_stamp_equals(const file_stamp_t *a, const file_stamp_t *b) {
+  return a->size == b->size && a->mtime_ns == b->mtime_ns && a->ino == b->ino;
+}
+
+/**
+ * @brief (辅助) 找到 `path` 所在的槽位, 或它应当插入的空槽位
+ */
+static cache_entry_t *find_slot(cache_entry_t *slots, size_t cap,
+                                const char *path) {
+  size_t mask = cap - 1;
+  size_t i = (size_t)cache_hash(path, strlen(path)) & mask;
+  while (slots[i].path && strcmp(slots[i].path, path) != 0) {
+    i = (i + 1) & mask;
+  }
+  return &slots[i];
+}
+
+static bool cache_grow(cache_t *cache) {
+  size_t new_cap = cache->cap ? cache->cap * 2 : CACHE_MIN_CAP;
+  cache_entry_t *new_slots =
+      allocer_alloc(cache->alc, layout_of_array(cache_entry_t, new_cap));
+  if (!new_slots)
+    return false;
+  memset(new_slots, 0, new_cap * sizeof(cache_entry_t));
+
+  for (size_t i = 0; i < cache->cap; i++) {
+    if (cache->slots[i].path)
+      *find_slot(new_slots, new_cap, cache->slots[i].path) = cache->slots[i];
+  }
+  cache->slots = new_slots;
+  cache->cap = new_cap;
+  return true;
+}
+
+/**
+ * @brief (辅助) 取得 `path` 的槽位, 不存在时插入一条空记录
+ */
+static cache_entry_t *cache_insert(cache_t *cache, const char *path,
+                                   size_t path_len) {
+  if ((cache->count + 1) * 2 > cache->cap && !cache_grow(cache))
+    return NULL;
+
+  cache_entry_t *slot = find_slot(cache->slots, cache->cap, path);
+  if (slot->path)
+    return slot;
+
+  char *stable_path =
+      allocer_alloc(cache->alc, layout_of_array(char, path_len + 1));
+  if (!stable_path)
+    return NULL;
+  memcpy(stable_path, path, path_len);
+  stable_path[path_len] = '\0';
+
+  memset(slot, 0, sizeof(*slot));
+  slot->path = stable_path;
+  cache->count++;
+  return slot;
+}
+
+/**
+ * @brief (辅助) 解析一个十六进制字段并跳过其后的空格
+ */
+static bool parse_hex(const char **p, const char *end, uint64_t *out) {
+  uint64_t value = 0;
+  const char *s = *p;
+  if (s == end || *s == ' ')
+    return false;
+  while (s < end && *s != ' ') {
+    char c = *s++;
+    uint64_t digit;
+    if (c >= '0' && c <= '9')
+      digit = (uint64_t)(c - '0');
+    else if (c >= 'a' && c <= 'f')
+      digit = (uint64_t)(c - 'a' + 10);
+    else
+      return false;
+    value = (value << 4) | digit;
+  }
+  if (s == end)
+    return false;
+  *p = s + 1;
+  *out = value;
+  return true;
+}
+
+/**
+ * @brief (辅助) 解析一行:
+ *        `size mtime_ns ino content style license output path`
+ */
+static bool parse_line(cache_t *cache, const char *p, const char *end) {
+  uint64_t fields[7] = {0};
+  for (size_t i = 0; i < 7; i++) {
+    if (!parse_hex(&p, end, &fields[i]))
+      return true;
+  }
+  if (p == end)
+    return true;
+
+  char path_buf[4096];
+  size_t path_len = (size_t)(end - p);
+  if (path_len >= sizeof(path_buf))
+    return true;
+  memcpy(path_buf, p, path_len);
+  path_buf[path_len] = '\0';
+
+  cache_entry_t *entry = cache_insert(cache, path_buf, path_len);
+  if (!entry)
+    return false;
+  entry->stamp.size = fields[0];
+  entry->stamp.mtime_ns = fields[1];
+  entry->stamp.ino = fields[2];
+  entry->content_hash = fields[3];
+  entry->style_hash = fields[4];
+  entry->license_hash = fields[5];
+  entry->output_hash = fields[6];
+  return true;
+}
+
+bool cache_load(cache_t *cache, allocer_t *alc, const char *file) {
+  memset(cache, 0, sizeof(*cache));
+  cache->alc = alc;
+  cache->file = file;
+  if (!cache_grow(cache))
+    return false;
+
+  if (access(file, F_OK) != 0)
+    return true;
+
+  str_slice_t content;
+  if (!read_file_to_slice(alc, file, &content))
+    return true;
+
+  size_t magic_len = strlen(CACHE_MAGIC);
+  if (content.len < magic_len || memcmp(content.ptr, CACHE_MAGIC, magic_len))
+    return true;
+
+  const char *p = content.ptr + magic_len;
+  const char *end = content.ptr + content.len;
+  while (p < end) {
+    const char *line_end = memchr(p, '\n', (size_t)(end - p));
+    if (!line_end)
+      break;
+    if (!parse_line(cache, p, line_end))
+      return false;
+    p = line_end + 1;
+  }
+  return true;
+}
+
+const cache_entry_t *cache_lookup(const cache_t *cache, const char *path) {
+  const cache_entry_t *slot = find_slot(cache->slots, cache->cap, path);
+  return slot->path ? slot : NULL;
+}
+
+bool cache_update(cache_t *cache, const char *path, const file_stamp_t *stamp,
+                  uint64_t content_hash, uint64_t style_hash,
+                  uint64_t license_hash, uint64_t output_hash) {
+  if (strchr(path, '\n'))
+    return true;
+
+  cache_entry_t *entry = cache_insert(cache, path, strlen(path));
+  if (!entry)
+    return false;
+
+  if (!file_stamp_equals(&entry->stamp, stamp)) {
+    entry->stamp = *stamp;
+    entry->content_hash = 0;
+    entry->style_hash = 0;
+    entry->license_hash = 0;
+    entry->output_hash = 0;
+  }
+  if (content_hash)
+    entry->content_hash = content_hash;
+  if (style_hash)
+    entry->style_hash = style_hash;
+  if (license_hash)
+    entry->license_hash = license_hash;
+  if (output_hash)
+    entry->output_hash = output_hash;
+  cache->dirty = true;
+  return true;
+}
+
+void cache_forget(cache_t *cache, const char *path) {
+  cache_entry_t *slot = find_slot(cache->slots, cache->cap, path);
+  if (!slot->path)
+    return;
+  memset(&slot->stamp, 0, sizeof(slot->stamp));
+  slot->content_hash = 0;
+  slot->style_hash = 0;
+  slot->license_hash = 0;
+  slot->output_hash = 0;
+  cache->dirty = true;
+}
+
+const cache_entry_t *cache_next(const cache_t *cache, size_t *iter) {
+  while (*iter < cache->cap) {
+    const cache_entry_t *entry = &cache->slots[(*iter)++];
+    if (entry->path)
+      return entry;
+  }
+  return NULL;
+}
+
+bool cache_save(cache_t *cache) {
+  if (!cache->dirty)
+    return true;
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  uint64_t now_ns =
+      (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+
+  string_t out;
+  if (!string_init(&out, cache->alc, 64 + cache->count * 96))
+    return false;
+  string_append_cstr(&out, CACHE_MAGIC);
+
+  for (size_t i = 0; i < cache->cap; i++) {
+    const cache_entry_t *entry = &cache->slots[i];
+    if (!entry->path || (!entry->content_hash && !entry->style_hash &&
+                         !entry->license_hash && !entry->output_hash))
+      continue;
+
+    /* 同一时间戳粒度内的后续修改无法从 stat 看出, 下次改为比较内容 */
+    uint64_t mtime_ns = entry->stamp.mtime_ns;
+    if (mtime_ns + CACHE_RACY_WINDOW_NS > now_ns)
+      mtime_ns = 0;
+
+    char line[192];
+    int n = snprintf(line, sizeof(line), "%llx %llx %llx %llx %llx %llx %llx ",
+                     (unsigned long long)entry->stamp.size,
+                     (unsigned long long)mtime_ns,
+                     (unsigned long long)entry->stamp.ino,
+                     (unsigned long long)entry->content_hash,
+                     (unsigned long long)entry->style_hash,
+                     (unsigned long long)entry->license_hash,
+                     (unsigned long long)entry->output_hash);
+    string_append_slice(&out, (str_slice_t){.ptr = line, .len = (size_t)n});
+    string_append_cstr(&out, entry->path);
+    string_push(&out, '\n');
+  }
+
+  str_slice_t bytes = string_as_slice(&out);
+  atomic_file_t af;
+  bool ok = atomic_file_open(&af, cache->alc, cache->file);
+  if (ok)
+    ok = atomic_file_write(&af, bytes.ptr, bytes.len);
+  if (ok)
+    ok = atomic_file_commit(&af);
+  else
+    atomic_file_abort(&af);
+
+  string_destroy(&out);
+  if (ok)
+    cache->dirty = false;
+  return ok;
+}
@@ -0,0 +1,352 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <clang_format.h>
+
+#include <core/mem/layout.h>
+#include <std/string/string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+#define CLANG_FORMAT_MAX_PREFIX 3
+#define CLANG_FORMAT_ARG_SLACK 4096
+
+typedef struct {
+  size_t first;
+  size_t count;
+  char **argv;
+  pid_t pid;
+  int spawn_err;
+  int status;
+  bool reaped;
+} format_batch_t;
+
+/**
+ * @brief 计算一批文件参数可用的字节数 (扣除环境变量与固定前缀)
+ */
+static size_t arg_budget(const char **prefix, size_t n_prefix) {
+  long arg_max = sysconf(_SC_ARG_MAX);
+  if (arg_max <= 0)
+    arg_max = 128 * 1024;
+
+  size_t used = CLANG_FORMAT_ARG_SLACK;
+  for (char **env = environ; env && *env; env++) {
+    used += strlen(*env) + 1 + sizeof(char *);
+  }
+  for (size_t i = 0; i < n_prefix; i++) {
+    used += strlen(prefix[i]) + 1 + sizeof(char *);
+  }
+  if ((size_t)arg_max <= used)
+    return 0;
+  return (size_t)arg_max - used;
+}
+
+static void report_batch_failure(format_batch_t *batch, size_t index,
+                                 size_t n_batches, vec_t *paths) {
+  if (batch->spawn_err != 0) {
+    fprintf(stderr,
+            "Warning: Could not run clang-format for batch %zu/%zu (%s), "
+            "%zu file(s) left unformatted:\n",
+            index + 1, n_batches, strerror(batch->spawn_err), batch->count);
+  } else if (!batch->reaped) {
+    fprintf(stderr,
+            "Warning: Lost track of clang-format in batch %zu/%zu "
+            "(%zu file(s)):\n",
+            index + 1, n_batches, batch->count);
+  } else if (WIFSIGNALED(batch->status)) {
+    fprintf(stderr,
+            "Warning: clang-format killed by signal %d in batch %zu/%zu "
+            "(%zu file(s)):\n",
+            WTERMSIG(batch->status), index + 1, n_batches, batch->count);
+  } else {
+    fprintf(stderr,
+            "Warning: clang-format exited with status %d in batch %zu/%zu "
+            "(%zu file(s)):\n",
+            WEXITSTATUS(batch->status), index + 1, n_batches, batch->count);
+  }
+  for (size_t i = 0; i < batch->count; i++) {
+    fprintf(stderr, "    %s\n",
+            (const char *)vec_get(paths, batch->first + i));
+  }
+}
+
+bool clang_format_files(allocer_t *alc, vec_t *paths, const char *style_file,
+                        size_t max_parallel) {
+  size_t n_paths = vec_count(paths);
+  if (n_paths == 0)
+    return true;
+  if (max_parallel == 0)
+    max_parallel = 1;
+
+  const char *prefix[CLANG_FORMAT_MAX_PREFIX];
+  size_t n_prefix = 0;
+  prefix[n_prefix++] = "clang-format";
+  prefix[n_prefix++] = "-i";
+
+  string_t style_arg;
+  if (!string_init(&style_arg, alc, 64))
+    return false;
+  if (style_file) {
+    string_append_cstr(&style_arg, "-style=file:");
+    string_append_cstr(&style_arg, style_file);
+    prefix[n_prefix++] = string_as_cstr(&style_arg);
+  }
+
+  size_t budget = arg_budget(prefix, n_prefix);
+  size_t per_batch = (n_paths + max_parallel - 1) / max_parallel;
+
+  format_batch_t *batches =
+      allocer_alloc(alc, layout_of_array(format_batch_t, n_paths));
+  if (!batches)
+    return false;
+
+  size_t n_batches = 0;
+  for (size_t i = 0; i < n_paths;) {
+    format_batch_t *batch = &batches[n_batches++];
+    memset(batch, 0, sizeof(*batch));
+    batch->first = i;
+
+    size_t used = 0;
+    while (i < n_paths && batch->count < per_batch) {
+      size_t cost =
+          strlen((const char *)vec_get(paths, i)) + 1 + sizeof(char *);
+      if (batch->count > 0 && used + cost > budget)
+        break;
+      used += cost;
+      batch->count++;
+      i++;
+    }
+
+    batch->argv = allocer_alloc(
+        alc, layout_of_array(char *, n_prefix + batch->count + 1));
+    if (!batch->argv)
+      return false;
+    for (size_t j = 0; j < n_prefix; j++) {
+      batch->argv[j] = (char *)prefix[j];
+    }
+    for (size_t j = 0; j < batch->count; j++) {
+      batch->argv[n_prefix + j] = (char *)vec_get(paths, batch->first + j);
+    }
+    batch->argv[n_prefix + batch->count] = NULL;
+  }
+
+  size_t next = 0;
+  size_t running = 0;
+  while (next < n_batches || running > 0) {
+    while (running < max_parallel && next < n_batches) {
+      format_batch_t *batch = &batches[next++];
+      batch->spawn_err = posix_spawnp(&batch->pid, "clang-format", NULL, NULL,
+                                      batch->argv, environ);
+      if (batch->spawn_err == 0)
+        running++;
+    }
+    if (running == 0)
+      break;
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    for (size_t i = 0; i < next; i++) {
+      if (batches[i].spawn_err == 0 && batches[i].pid == pid) {
+        batches[i].status = status;
+        batches[i].reaped = true;
+        running--;
+        break;
+      }
+    }
+  }
+
+  bool ok = true;
+  for (size_t i = 0; i < n_batches; i++) {
+    format_batch_t *batch = &batches[i];
+    if (batch->spawn_err == 0 && batch->reaped && WIFEXITED(batch->status) &&
+        WEXITSTATUS(batch->status) == 0)
+      continue;
+    report_batch_failure(batch, i, n_batches, paths);
+    ok = false;
+  }
+
+  string_destroy(&style_arg);
+  return ok;
+}
+
+static pthread_once_t sigpipe_once = PTHREAD_ONCE_INIT;
+
+static void ignore_sigpipe(void) { signal(SIGPIPE, SIG_IGN); }
+
+/**
+ * @brief 同时向子进程写 stdin 并读取其 stdout, 避免管道互相阻塞
+ */
+static bool pump_pipes(int in_fd, int out_fd, str_slice_t input,
+                       string_t *out) {
+  size_t written = 0;
+  bool ok = true;
+  char buf[64 * 1024];
+
+  if (input.len == 0) {
+    close(in_fd);
+    in_fd = -1;
+  } else {
+    fcntl(in_fd, F_SETFL, fcntl(in_fd, F_GETFL) | O_NONBLOCK);
+  }
+
+  for (;;) {
+    struct pollfd fds[2] = {
+        {.fd = out_fd, .events = POLLIN},
+        {.fd = in_fd, .events = POLLOUT},
+    };
+    if (poll(fds, in_fd >= 0 ? 2 : 1, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = false;
+      break;
+    }
+
+    if (in_fd >= 0 && fds[1].revents != 0) {
+      ssize_t n = write(in_fd, input.ptr + written, input.len - written);
+      if (n > 0) {
+        written += (size_t)n;
+      } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        ok = false;
+      }
+      if (written == input.len || !ok) {
+        close(in_fd);
+        in_fd = -1;
+      }
+    }
+
+    if (fds[0].revents != 0) {
+      ssize_t n = read(out_fd, buf, sizeof(buf));
+      if (n > 0) {
+        string_append_slice(out, (str_slice_t){.ptr = buf, .len = (size_t)n});
+      } else if (n == 0) {
+        break;
+      } else if (errno != EINTR && errno != EAGAIN) {
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  if (in_fd >= 0) {
+    close(in_fd);
+    ok = false;
+  }
+  return ok;
+}
+
+bool clang_format_pipe(allocer_t *alc, const char *style_file,
+                       const char *assume_filename, str_slice_t input,
+                       string_t *out, report_t *rep) {
+  pthread_once(&sigpipe_once, ignore_sigpipe);
+
+  string_t style_arg, assume_arg;
+  if (!string_init(&style_arg, alc, 64) || !string_init(&assume_arg, alc, 64))
+    return false;
+  string_append_cstr(&assume_arg, "--assume-filename=");
+  string_append_cstr(&assume_arg, assume_filename);
+
+  char *argv[4];
+  size_t argc = 0;
+  argv[argc++] = "clang-format";
+  if (style_file) {
+    string_append_cstr(&style_arg, "-style=file:");
+    string_append_cstr(&style_arg, style_file);
+    argv[argc++] = (char *)string_as_cstr(&style_arg);
+  }
+  argv[argc++] = (char *)string_as_cstr(&assume_arg);
+  argv[argc] = NULL;
+
+  int in_pipe[2], out_pipe[2];
+  if (pipe2(in_pipe, O_CLOEXEC) != 0) {
+    report_err(rep, "Error: pipe() failed for '%s': %s\n", assume_filename,
+               strerror(errno));
+    return false;
+  }
+  if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+    report_err(rep, "Error: pipe() failed for '%s': %s\n", assume_filename,
+               strerror(errno));
+    close(in_pipe[0]);
+    close(in_pipe[1]);
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, "clang-format", &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(in_pipe[0]);
+  close(out_pipe[1]);
+
+  if (err != 0) {
+    report_err(rep, "Error: Could not run clang-format for '%s' (%s)\n",
+               assume_filename, strerror(err));
+    close(in_pipe[1]);
+    close(out_pipe[0]);
+    return false;
+  }
+
+  bool pumped = pump_pipes(in_pipe[1], out_pipe[0], input, out);
+  close(out_pipe[0]);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      status = -1;
+      break;
+    }
+  }
+
+  string_destroy(&assume_arg);
+  string_destroy(&style_arg);
+
+  if (status != -1 && WIFSIGNALED(status)) {
+    report_err(rep, "Error: clang-format killed by signal %d for '%s'\n",
+               WTERMSIG(status), assume_filename);
+    return false;
+  }
+  if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    report_err(rep, "Error: clang-format failed for '%s' (status %d)\n",
+               assume_filename, status == -1 ? -1 : WEXITSTATUS(status));
+    return false;
+  }
+  if (!pumped) {
+    report_err(rep, "Error: Lost output of clang-format for '%s'\n",
+               assume_filename);
+    return false;
+  }
+  return true;
+}
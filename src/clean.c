@@ -14,9 +14,24 @@
  *    limitations under the License.
  */
 
+#define _GNU_SOURCE
+#include <cache.h>
+#include <clang_format.h>
 #include <clean.h>
+#include <exclude.h>
+#include <git_changed.h>
+#include <lex.h>
+#include <path_list.h>
+#include <pool.h>
+#include <report.h>
+#include <scan.h>
+#include <stdio_filter.h>
+#include <strip.h>
+#include <walk.h>
 
 #include <core/mem/layout.h>
+#include <std/allocer/bump/bump.h>
+#include <std/allocer/bump/glue.h>
 #include <core/msg/asrt.h>
 #include <std/io/file.h>
 #include <std/string/str_slice.h>
@@ -27,18 +42,10 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-typedef enum {
-  STATE_CODE,
-  STATE_LINE_COMMENT,
-  STATE_BLOCK_COMMENT,
-  STATE_STRING,
-  STATE_CHAR,
-} clean_state_t;
-
 /**
  * @brief (辅助) 复制一个 C 字符串到 Arena
  */
@@ -52,124 +59,246 @@ static inline char *allocer_strdup(allocer_t *alc, const char *s) {
   return new_s;
 }
 
-static bool clean_single_file(allocer_t *alc, const char *filename,
-                              const char *style_file) {
+/* 过滤模式下未指定 --assume-filename 时, clang-format 按 C 源码处理 */
+#define CLEAN_STDIN_FILENAME "stdin.c"
 
-  printf("  Cleaning: %s\n", filename);
+/**
+ * @brief 一个待清理的文件; 除 `path`/`stamp`/`cached_hash` 外都由工作线程填写
+ */
+typedef struct {
+  const char *path;
+  /* 提交前的 stat 元组 (仅 incremental) */
+  file_stamp_t stamp;
+  /* 清单中可复用的内容哈希, 0 表示没有 */
+  uint64_t cached_hash;
+  /* 处理后的内容哈希, 0 表示需要重新读取文件计算 */
+  uint64_t content_hash;
+  /* 交给 clang-format -i 之前的 stat 元组, 用于判断它是否改写了文件 */
+  file_stamp_t pre_format;
+  bool ok;
+  bool written;
+  bool cache_hit;
+  bool needs_format;
+  /* 按块流式处理过, 清单中不记录内容哈希 */
+  bool streamed;
+  /* (仅 check) 已被检查; --fail-fast 取消后剩下的文件为 false */
+  bool checked;
+  /* (仅 check) 清理会改动该文件 */
+  bool dirty;
+  /* (主线程填写) 本次运行是否改动了文件内容 */
+  bool changed;
+} clean_file_t;
+
+/**
+ * @brief (工作线程) 流式清理一个很大的文件
+ *
+ * 按块删除注释并写入临时文件, 没有注释可删时放弃临时文件。
+ * 不计算内容哈希, 增量模式下只靠 stat 元组跳过。
+ */
+static bool clean_streamed_file(allocer_t *alc, clean_file_t *file,
+                                const clean_opts_t *opts, report_t *rep) {
+  const char *filename = file->path;
+  file->streamed = true;
+  if (!opts->check)
+    report_out(rep, "  Cleaning: %s\n", filename);
+
+  int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    report_err(rep, "Error: Failed to read file '%s'.\n", filename);
+    return false;
+  }
+
+  atomic_file_t af;
+  atomic_file_t *out = opts->check ? NULL : &af;
+  if (out && !atomic_file_open(out, alc, filename)) {
+    atomic_file_abort(out);
+    close(fd);
+    report_err(rep, "Error: Failed to write file '%s'.\n", filename);
+    return false;
+  }
+
+  size_t removed = 0;
+  bool ok = strip_line_comments_fd(alc, scan_select(), fd, out, &removed);
+  close(fd);
+  if (!ok) {
+    if (out)
+      atomic_file_abort(out);
+    report_err(rep, "Error: Failed to clean file '%s'.\n", filename);
+    return false;
+  }
+
+  if (opts->check) {
+    if (removed > 0) {
+      file->dirty = true;
+      report_out(rep, "  Needs cleaning: %s\n", filename);
+    }
+    return true;
+  }
+
+  if (removed == 0) {
+    atomic_file_abort(out);
+  } else if (atomic_file_commit(out)) {
+    file->written = true;
+  } else {
+    report_err(rep, "Error: Failed to write file '%s'.\n", filename);
+    return false;
+  }
+
+  struct stat st;
+  if (stat(filename, &st) == 0)
+    file_stamp_from_stat(&st, &file->pre_format);
+  return true;
+}
+
+static bool clean_single_file(allocer_t *alc, clean_file_t *file,
+                              const clean_opts_t *opts, report_t *rep) {
+  const char *filename = file->path;
+
+  /* 管道模式需要整个缓冲区交给 clang-format, 只能整体读入 */
+  struct stat st;
+  if (!opts->pipe && stat(filename, &st) == 0 &&
+      (size_t)st.st_size >= LEX_STREAM_MIN_SIZE)
+    return clean_streamed_file(alc, file, opts, rep);
 
   str_slice_t content;
   if (!read_file_to_slice(alc, filename, &content)) {
-    fprintf(stderr, "Error: Failed to read file '%s'.\n", filename);
+    if (!opts->check)
+      report_out(rep, "  Cleaning: %s\n", filename);
+    report_err(rep, "Error: Failed to read file '%s'.\n", filename);
     return false;
   }
 
+  uint64_t original_hash = 0;
+  if (opts->incremental) {
+    original_hash = cache_hash(content.ptr, content.len);
+    if (original_hash == file->cached_hash) {
+      file->content_hash = original_hash;
+      file->cache_hit = true;
+      return true;
+    }
+  }
+
+  if (!opts->check)
+    report_out(rep, "  Cleaning: %s\n", filename);
+
   string_t builder;
   string_init(&builder, alc, content.len);
 
-  clean_state_t state = STATE_CODE;
-  const char *p = content.ptr;
-  const char *end = content.ptr + content.len;
-
-  while (p < end) {
-    char c = *p;
-    char next = (p + 1 < end) ? *(p + 1) : '\0';
-
-    switch (state) {
-    case STATE_CODE:
-      if (c == '/' && next == '/') {
-        state = STATE_LINE_COMMENT;
-        p++;
-      } else if (c == '/' && next == '*') {
-        state = STATE_BLOCK_COMMENT;
-        string_push(&builder, c);
-        string_push(&builder, next);
-        p++;
-      } else if (c == '"') {
-        state = STATE_STRING;
-        string_push(&builder, c);
-      } else if (c == '\'') {
-        state = STATE_CHAR;
-        string_push(&builder, c);
-      } else {
-        string_push(&builder, c);
-      }
-      break;
-    case STATE_LINE_COMMENT:
-      if (c == '\n') {
-        state = STATE_CODE;
-        string_push(&builder, c);
-      }
-      break;
-    case STATE_BLOCK_COMMENT:
-      string_push(&builder, c);
-      if (c == '*' && next == '/') {
-        state = STATE_CODE;
-        string_push(&builder, next);
-        p++;
-      }
-      break;
-    case STATE_STRING:
-      string_push(&builder, c);
-      if (c == '\\') {
-        if (next != '\0') {
-          string_push(&builder, next);
-          p++;
-        }
-      } else if (c == '"') {
-        state = STATE_CODE;
-      }
-      break;
-    case STATE_CHAR:
-      string_push(&builder, c);
-      if (c == '\\') {
-        if (next != '\0') {
-          string_push(&builder, next);
-          p++;
-        }
-      } else if (c == '\'') {
-        state = STATE_CODE;
-      }
-      break;
+  strip_line_comments(scan_select(), content, &builder);
+
+  str_slice_t result_slice = string_as_slice(&builder);
+
+  string_t formatted;
+  if (opts->pipe) {
+    if (!string_init(&formatted, alc, result_slice.len + 256) ||
+        !clang_format_pipe(alc, opts->style_file, filename, result_slice,
+                           &formatted, rep)) {
+      string_destroy(&builder);
+      return false;
     }
-    p++;
+    result_slice = string_as_slice(&formatted);
   }
 
-  str_slice_t result_slice = string_as_slice(&builder);
-  if (!write_file_bytes(filename, (const void *)result_slice.ptr,
-                        result_slice.len)) {
-    fprintf(stderr, "Error: Failed to write file '%s'.\n", filename);
-    string_destroy(&builder);
-    return false;
+  bool same = result_slice.len == content.len &&
+              memcmp(result_slice.ptr, content.ptr, content.len) == 0;
+
+  /* 内容没变就不写, 以免无谓地更新 mtime 触发增量构建 */
+  bool ok = true;
+  if (opts->check) {
+    if (!same) {
+      file->dirty = true;
+      report_out(rep, "  Needs cleaning: %s\n", filename);
+    }
+  } else if (same) {
+    file->content_hash = original_hash;
+  } else if (write_file_bytes(filename, (const void *)result_slice.ptr,
+                              result_slice.len)) {
+    file->written = true;
+    if (opts->pipe && opts->incremental)
+      file->content_hash = cache_hash(result_slice.ptr, result_slice.len);
+  } else {
+    report_err(rep, "Error: Failed to write file '%s'.\n", filename);
+    ok = false;
+  }
+
+  if (!opts->pipe && !opts->check) {
+    struct stat st;
+    if (stat(filename, &st) == 0)
+      file_stamp_from_stat(&st, &file->pre_format);
   }
+
+  if (opts->pipe)
+    string_destroy(&formatted);
   string_destroy(&builder);
+  return ok;
+}
 
-  string_t cmd;
-  string_init(&cmd, alc, 256);
-  string_append_cstr(&cmd, "clang-format -i ");
-  if (style_file) {
-    string_append_cstr(&cmd, "-style=file:");
-    string_append_cstr(&cmd, style_file);
-    string_push(&cmd, ' ');
-  }
-  string_append_cstr(&cmd, filename);
-  int ret = system(string_as_cstr(&cmd));
-  if (ret != 0) {
-    fprintf(stderr,
-            "Warning: clang-format command failed (is it installed?)\n");
-  }
-  string_destroy(&cmd);
-  return true;
+static bool clean_job(void *ctx, job_worker_t *worker, void *job,
+                      report_t *rep) {
+  const clean_opts_t *opts = ctx;
+  clean_file_t *file = job;
+  file->checked = true;
+  file->ok = clean_single_file(&worker->scratch, file, opts, rep);
+  file->needs_format =
+      file->ok && !file->cache_hit && !opts->pipe && !opts->check;
+  if (opts->fail_fast && (!file->ok || file->dirty))
+    job_pool_cancel(worker->pool);
+  return file->ok;
 }
 
-static bool is_excluded(const char *path, vec_t *exclusions) {
-  for (size_t i = 0; i < vec_count(exclusions); i++) {
-    const char *pattern = (const char *)vec_get(exclusions, i);
-    if (strstr(path, pattern) != NULL) {
-      printf("  Excluding: %s (matches '%s')\n", path, pattern);
-      return true;
+typedef struct {
+  allocer_t *alc;
+  const exclude_set_t *exclude;
+  bool verbose;
+  unsigned walk_flags;
+  job_pool_t *pool;
+  vec_t *files;
+  /* 仅 incremental: 清单与当前格式化配置的哈希 */
+  const cache_t *cache;
+  uint64_t style_hash;
+  size_t skipped;
+} clean_walk_t;
+
+/**
+ * @brief 判断路径是否被排除; 只有 verbose 时才打印命中的模式
+ */
+static bool is_excluded(clean_walk_t *walk, const char *path, bool is_dir) {
+  const char *pattern =
+      exclude_match(walk->exclude, slice_from_cstr(path), is_dir);
+  if (pattern && walk->verbose) {
+    job_pool_note(walk->pool, stdout, "  Excluding: %s (matches '%s')\n",
+                  path, pattern);
+  }
+  return pattern != NULL;
+}
+
+/**
+ * @brief 提交一个文件; incremental 模式下 stat 元组未变的文件直接跳过
+ */
+static void submit_clean_file(clean_walk_t *walk, const char *path) {
+  clean_file_t *file = allocer_alloc(walk->alc, layout_of(clean_file_t));
+  if (!file)
+    return;
+  memset(file, 0, sizeof(*file));
+  file->path = path;
+
+  if (walk->cache) {
+    struct stat st;
+    if (stat(path, &st) == 0) {
+      file_stamp_from_stat(&st, &file->stamp);
+      const cache_entry_t *entry = cache_lookup(walk->cache, path);
+      if (entry && entry->style_hash == walk->style_hash) {
+        if (file_stamp_equals(&entry->stamp, &file->stamp)) {
+          walk->skipped++;
+          return;
+        }
+        file->cached_hash = entry->content_hash;
+      }
     }
   }
-  return false;
+
+  if (vec_push(walk->files, file))
+    job_pool_submit(walk->pool, file);
 }
 
 static bool is_cleanable_file(const char *filename) {
@@ -183,90 +312,321 @@ static bool is_cleanable_file(const char *filename) {
   return false;
 }
 
-static void traverse_dir_for_clean(allocer_t *alc, const char *current_path,
-                                   vec_t *exclusions, const char *style_file,
-                                   string_t *path_builder) {
-  DIR *dir = opendir(current_path);
-  if (!dir) {
-    fprintf(stderr, "Warning: Could not open directory '%s'\n", current_path);
-    return;
+static bool clean_visit(void *ctx, const walk_entry_t *entry) {
+  clean_walk_t *walk = ctx;
+  const char *full_path = entry->path.ptr;
+
+  if (job_pool_cancelled(walk->pool))
+    return false;
+
+  switch (entry->kind) {
+  case WALK_ERR_OPEN_DIR:
+    job_pool_note(walk->pool, stderr,
+                  "Warning: Could not open directory '%s'\n", full_path);
+    return false;
+  case WALK_ERR_STAT:
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat file '%s'\n",
+                  full_path);
+    return false;
+  default:
+    break;
   }
 
-  struct dirent *dp;
-  while ((dp = readdir(dir)) != NULL) {
-    const char *name = dp->d_name;
-    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-      continue;
+  if (is_excluded(walk, full_path, entry->kind == WALK_DIR)) {
+    return false;
+  }
+
+  if (entry->kind == WALK_FILE && is_cleanable_file(full_path)) {
+    char *stable_path = allocer_strdup(walk->alc, full_path);
+    if (stable_path) {
+      submit_clean_file(walk, stable_path);
     }
+  }
+  return true;
+}
 
-    string_clear(path_builder);
-    string_append_cstr(path_builder, current_path);
+/**
+ * @brief 处理一个路径: 目录则遍历 (仅当 `walk_dirs`), 普通文件则直接提交
+ *
+ * @param path 须在整个运行期间有效
+ * @return false 表示已被 --fail-fast 取消, 不必再处理后续目标
+ */
+static bool clean_path(clean_walk_t *walk, const char *path,
+                  bool walk_dirs) {
+  if (job_pool_cancelled(walk->pool))
+    return false;
 
-    if (current_path[strlen(current_path) - 1] != '/') {
-      string_push(path_builder, '/');
-    }
-    string_append_cstr(path_builder, name);
+  struct stat statbuf;
+  if (stat(path, &statbuf) != 0) {
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat target '%s'\n",
+                  path);
+    return true;
+  }
 
-    const char *full_path = string_as_cstr(path_builder);
+  if (is_excluded(walk, path, S_ISDIR(statbuf.st_mode))) {
+    return true;
+  }
 
-    if (is_excluded(full_path, exclusions)) {
-      continue;
-    }
+  if (S_ISDIR(statbuf.st_mode)) {
+    if (walk_dirs)
+      walk_tree(walk->alc, path, walk->walk_flags, clean_visit, walk);
+  } else if (S_ISREG(statbuf.st_mode) && is_cleanable_file(path)) {
+    submit_clean_file(walk, path);
+  }
+  return !job_pool_cancelled(walk->pool);
+}
 
-    struct stat statbuf;
-    if (stat(full_path, &statbuf) != 0) {
-      fprintf(stderr, "Warning: Could not stat file '%s'\n", full_path);
-      continue;
-    }
+/**
+ * @brief 处理命令行上的一个目标: 目录则遍历, 文件则直接提交
+ */
+static bool clean_target(void *ctx, const char *path) {
+  return clean_path(ctx, path, true);
+}
+
+/**
+ * @brief --files-from / --changed-since 回调: 只接受普通文件
+ *
+ * 列表中的目录 (例如 git 列出的子模块) 不展开, 以免处理整个第三方代码树。
+ */
+static bool clean_listed_path(void *ctx, const char *path) {
+  clean_walk_t *walk = ctx;
+  char *stable_path = allocer_strdup(walk->alc, path);
+  if (!stable_path)
+    return false;
+  return clean_path(walk, stable_path, false);
+}
+
+/**
+ * @brief 计算影响 clean 输出的配置的哈希: 程序版本与 .clang-format 内容
+ *
+ * 未指定 `style_file` 时使用当前目录下的 .clang-format (若存在)。
+ */
+static uint64_t clean_style_hash(allocer_t *alc, const clean_opts_t *opts) {
+  static const char version[] = "cnote-clean/1";
+  uint64_t h = cache_hash(version, sizeof(version) - 1);
+
+  const char *style_file = opts->style_file;
+  if (!style_file && access(".clang-format", R_OK) == 0)
+    style_file = ".clang-format";
+
+  str_slice_t style;
+  if (style_file && read_file_to_slice(alc, style_file, &style))
+    h = cache_hash_more(h, style.ptr, style.len);
+  return h;
+}
 
-    if (S_ISDIR(statbuf.st_mode)) {
+/**
+ * @brief 把处理成功的文件写入清单, 失败的文件从清单中移除
+ */
+static void record_clean_file(cache_t *cache, clean_file_t *file,
+                              bool format_ok, uint64_t style_hash) {
+  if (!file->ok || (file->needs_format && !format_ok)) {
+    cache_forget(cache, file->path);
+    return;
+  }
 
-      char *stable_path = allocer_strdup(alc, full_path);
-      if (stable_path) {
-        traverse_dir_for_clean(alc, stable_path, exclusions, style_file,
-                               path_builder);
+  file_stamp_t stamp = file->stamp;
+  uint64_t content_hash = file->content_hash;
+  if (file->changed) {
+    /* 先 stat 再读: 两者之间若被修改, 下次只会多校验一次内容 */
+    struct stat st;
+    if (stat(file->path, &st) != 0) {
+      cache_forget(cache, file->path);
+      return;
+    }
+    file_stamp_from_stat(&st, &stamp);
+    if (content_hash == 0 && !file->streamed) {
+      bump_t scratch_arena;
+      bump_init(&scratch_arena);
+      allocer_t scratch = bump_to_allocer(&scratch_arena);
+      str_slice_t content;
+      bool read_ok = read_file_to_slice(&scratch, file->path, &content);
+      if (read_ok)
+        content_hash = cache_hash(content.ptr, content.len);
+      bump_destroy(&scratch_arena);
+      if (!read_ok) {
+        cache_forget(cache, file->path);
+        return;
       }
-    } else if (is_cleanable_file(full_path)) {
-      clean_single_file(alc, full_path, style_file);
     }
   }
-  closedir(dir);
+  cache_update(cache, file->path, &stamp, content_hash, style_hash, 0, 0);
+}
+
+bool cnote_clean_stdin(allocer_t *alc, const clean_opts_t *opts) {
+  str_slice_t content;
+  if (!stdio_filter_read(alc, &content))
+    return false;
+
+  string_t stripped, formatted;
+  report_t rep;
+  if (!string_init(&stripped, alc, content.len) ||
+      !string_init(&formatted, alc, content.len + 256) ||
+      !report_init(&rep, alc))
+    return false;
+
+  strip_line_comments(scan_select(), content, &stripped);
+
+  const char *assume_filename =
+      opts->assume_filename ? opts->assume_filename : CLEAN_STDIN_FILENAME;
+  bool ok = clang_format_pipe(alc, opts->style_file, assume_filename,
+                              string_as_slice(&stripped), &formatted, &rep);
+  report_flush(&rep);
+  if (ok)
+    ok = stdio_filter_write(string_as_slice(&formatted));
+
+  string_destroy(&formatted);
+  string_destroy(&stripped);
+  return ok;
+}
+
+/**
+ * @brief (仅 check) 打印检查结果
+ *
+ * @return true 没有需要清理的文件
+ */
+static bool report_clean_check(vec_t *files, size_t skipped, bool stopped) {
+  size_t n_checked = skipped, n_dirty = 0, n_failed = 0;
+  for (size_t i = 0; i < vec_count(files); i++) {
+    clean_file_t *file = vec_get(files, i);
+    if (!file->checked)
+      continue;
+    n_checked++;
+    if (!file->ok)
+      n_failed++;
+    else if (file->dirty)
+      n_dirty++;
+  }
+  printf("  %zu of %zu file(s) need cleaning", n_dirty, n_checked);
+  if (n_failed > 0)
+    printf(", %zu failed", n_failed);
+  if (stopped)
+    printf(" (stopped at the first failure)");
+  printf(".\n");
+  return n_dirty == 0;
 }
 
 bool cnote_clean_run(allocer_t *alc, vec_t *targets, vec_t *exclusions,
-                     const char *style_file) {
-  string_t path_builder;
-  if (!string_init(&path_builder, alc, 256)) {
+                     const clean_opts_t *opts) {
+  vec_t files;
+  if (!vec_init(&files, alc, 0)) {
     return false;
   }
 
-  for (size_t i = 0; i < vec_count(targets); i++) {
-    const char *target_path = (const char *)vec_get(targets, i);
+  cache_t cache;
+  uint64_t style_hash = 0;
+  if (opts->incremental) {
+    if (!cache_load(&cache, alc, CACHE_DEFAULT_FILE))
+      return false;
+    style_hash = clean_style_hash(alc, opts);
+  }
 
-    if (is_excluded(target_path, exclusions)) {
-      continue;
-    }
+  exclude_set_t exclude;
+  if (!exclude_set_init(&exclude, alc, exclusions)) {
+    return false;
+  }
 
-    struct stat statbuf;
-    if (stat(target_path, &statbuf) != 0) {
-      fprintf(stderr, "Warning: Could not stat target '%s'\n", target_path);
-      continue;
+  job_pool_t pool;
+  if (!job_pool_init(&pool, alc, opts->jobs, clean_job, (void *)opts)) {
+    return false;
+  }
+
+  clean_walk_t walk = {
+      .alc = alc,
+      .exclude = &exclude,
+      .verbose = opts->verbose,
+      .walk_flags = opts->no_ignore ? WALK_NO_FLAGS : WALK_HONOR_IGNORE,
+      .pool = &pool,
+      .files = &files,
+      .cache = opts->incremental ? &cache : NULL,
+      .style_hash = style_hash,
+      .skipped = 0,
+  };
+
+  bool list_ok = true;
+  if (opts->changed_since) {
+    list_ok = git_changed_files(alc, opts->changed_since, NULL, targets,
+                                clean_listed_path, &walk);
+  } else {
+    for (size_t i = 0; i < vec_count(targets); i++) {
+      if (!clean_target(&walk, (const char *)vec_get(targets, i)))
+        break;
     }
+  }
+  if (opts->files_from &&
+      !path_list_read(alc, opts->files_from, clean_listed_path, &walk)) {
+    list_ok = false;
+  }
 
-    if (S_ISDIR(statbuf.st_mode)) {
+  bool jobs_ok = job_pool_wait(&pool);
+  bool stopped = job_pool_cancelled(&pool);
+  job_pool_destroy(&pool);
 
-      char *stable_path = allocer_strdup(alc, target_path);
-      if (stable_path) {
-        traverse_dir_for_clean(alc, stable_path, exclusions, style_file,
-                               &path_builder);
-      }
-    } else {
-      if (is_cleanable_file(target_path)) {
-        clean_single_file(alc, target_path, style_file);
+  if (opts->check) {
+    bool clean_ok = report_clean_check(&files, walk.skipped, stopped);
+    vec_destroy(&files);
+    /* 被取消时路径列表的读取会提前结束, 那不算额外的错误 */
+    return clean_ok && jobs_ok && (list_ok || stopped);
+  }
+
+  vec_t to_format;
+  if (!vec_init(&to_format, alc, vec_count(&files))) {
+    return false;
+  }
+  for (size_t i = 0; i < vec_count(&files); i++) {
+    clean_file_t *file = vec_get(&files, i);
+    if (file->needs_format)
+      vec_push(&to_format, (void *)file->path);
+  }
+
+  bool format_ok =
+      clang_format_files(alc, &to_format, opts->style_file, opts->jobs);
+  bool ok = format_ok && jobs_ok && list_ok;
+
+  size_t n_changed = 0, n_unchanged = walk.skipped, n_failed = 0;
+  size_t n_cached = walk.skipped;
+  for (size_t i = 0; i < vec_count(&files); i++) {
+    clean_file_t *file = vec_get(&files, i);
+    if (!file->ok) {
+      n_failed++;
+      continue;
+    }
+    if (file->cache_hit)
+      n_cached++;
+    file->changed = file->written;
+    if (file->needs_format) {
+      struct stat st;
+      file_stamp_t after = {0};
+      if (stat(file->path, &st) == 0)
+        file_stamp_from_stat(&st, &after);
+      if (!file_stamp_equals(&after, &file->pre_format)) {
+        file->changed = true;
+        file->content_hash = 0;
       }
     }
+    if (file->changed)
+      n_changed++;
+    else
+      n_unchanged++;
+  }
+  printf("  %zu file(s) changed, %zu unchanged", n_changed, n_unchanged);
+  if (opts->incremental)
+    printf(" (%zu skipped via %s)", n_cached, CACHE_DEFAULT_FILE);
+  if (n_failed > 0)
+    printf(", %zu failed", n_failed);
+  printf(".\n");
+
+  if (opts->incremental) {
+    for (size_t i = 0; i < vec_count(&files); i++) {
+      record_clean_file(&cache, vec_get(&files, i), format_ok, style_hash);
+    }
+    if (!cache_save(&cache)) {
+      fprintf(stderr, "Warning: Could not write cache file '%s'\n",
+              CACHE_DEFAULT_FILE);
+    }
   }
 
-  string_destroy(&path_builder);
-  return true;
+  vec_destroy(&to_format);
+  vec_destroy(&files);
+  return ok;
 }
\ No newline at end of file
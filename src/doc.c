@@ -16,7 +16,17 @@
 
 
 
+#define _GNU_SOURCE
+#include <cache.h>
 #include <doc.h>
+#include <doc_index.h>
+#include <doc_search.h>
+#include <doc_xref.h>
+#include <git_changed.h>
+#include <lex.h>
+#include <pool.h>
+#include <report.h>
+#include <walk.h>
 
 #include <core/mem/layout.h>
 #include <core/msg/asrt.h>
@@ -27,11 +37,18 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+/* doc 清单的文件名, 位于 out_dir 中 */
+#define DOC_MANIFEST_FILE ".cnote-doc-cache"
+/* 条目提取的版本; 改变解析结果时递增, 让旧清单中的源文件全部重新解析 */
+#define DOC_PARSE_VERSION "cnote-doc 1\n"
+
 static inline char *allocer_strdup(allocer_t *alc, const char *s) {
   size_t len = strlen(s);
   layout_t layout = layout_of_array(char, len + 1);
@@ -54,7 +71,7 @@ static bool ensure_directory(const char *path) {
   return false;
 }
 
-static void sanitize_path_to_filename(str_slice_t path, string_t *out_builder) {
+void doc_page_name(str_slice_t path, string_t *out_builder) {
   for (size_t i = 0; i < path.len; i++) {
     char c = path.ptr[i];
     if (c == '/' || c == '.') {
@@ -66,20 +83,6 @@ static void sanitize_path_to_filename(str_slice_t path, string_t *out_builder) {
   string_append_cstr(out_builder, ".md");
 }
 
-/**
- * @brief [修改] doc_entry_t 不再需要存储 filepath
- */
-typedef struct {
-  str_slice_t comment;
-  str_slice_t signature;
-} doc_entry_t;
-
-typedef enum {
-  DOC_STATE_CODE,
-  DOC_STATE_COMMENT,
-  DOC_STATE_SIGNATURE
-} doc_parse_state_t;
-
 static const char *skip_whitespace(const char *p, const char *end) {
   while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
     p++;
@@ -88,61 +91,107 @@ static const char *skip_whitespace(const char *p, const char *end) {
 }
 
 /**
- * @brief [修改] 不再需要 filepath, 因为它只解析
+ * @brief 若片段是完整的文档注释 (以两个星号开头的块注释), 取出正文
  */
-static void parse_file_for_docs(allocer_t *alc, vec_t *entries_vec,
-                                str_slice_t file_content) {
-  doc_parse_state_t state = DOC_STATE_CODE;
-  const char *p = file_content.ptr;
-  const char *end = file_content.ptr + file_content.len;
+static bool doc_comment_body(const lex_token_t *tok, str_slice_t *body) {
+  if (tok->kind != LEX_BLOCK_COMMENT || !tok->terminated ||
+      tok->text.len < 5 || tok->text.ptr[2] != '*')
+    return false;
+  *body = (str_slice_t){.ptr = tok->text.ptr + 3, .len = tok->text.len - 5};
+  return true;
+}
 
-  const char *comment_start = NULL, *comment_end = NULL,
-             *signature_start = NULL;
+/**
+ * @brief 逐个片段解析文档注释及其后的声明
+ *
+ * 声明从注释后第一个非空白字符开始, 到代码中第一个 `{` 或 `;` 为止;
+ * 字面量与注释中的这些字符, 以及字符串里形似文档注释的内容都不算数。
+ * 注释与声明都复制到 `alc` 中, 因此片段可以来自流式读取的临时缓冲区。
+ */
+typedef struct {
+  allocer_t *alc;
+  vec_t *entries;
+  /* 最近一个还没配上声明的文档注释 */
+  string_t comment;
+  bool has_comment;
+  /* 已经开始累积的声明 */
+  string_t signature;
+  bool in_signature;
+} doc_parser_t;
 
-  while (p < end) {
-    char c = *p;
-    char next = (p + 1 < end) ? *(p + 1) : '\0';
-    char next2 = (p + 2 < end) ? *(p + 2) : '\0';
-    switch (state) {
-    case DOC_STATE_CODE:
-      if (c == '/' && next == '*' && next2 == '*') {
-        state = DOC_STATE_COMMENT;
-        comment_start = p + 3;
-        p += 2;
-      }
-      break;
-    case DOC_STATE_COMMENT:
-      if (c == '*' && next == '/') {
-        state = DOC_STATE_SIGNATURE;
-        comment_end = p;
-        signature_start = skip_whitespace(p + 2, end);
-        p += 1;
-      }
-      break;
-    case DOC_STATE_SIGNATURE:
-      if (c == '{' || c == ';') {
-        doc_entry_t *entry = allocer_alloc(alc, layout_of(doc_entry_t));
-        if (!entry)
-          return;
-        entry->comment = (str_slice_t){
-            .ptr = comment_start, .len = (size_t)(comment_end - comment_start)};
-        entry->signature = (str_slice_t){
-            .ptr = signature_start, .len = (size_t)(p - signature_start + 1)};
-        if (!vec_push(entries_vec, (void *)entry))
-          return;
-        state = DOC_STATE_CODE;
-        comment_start = NULL;
-        comment_end = NULL;
-        signature_start = NULL;
-      }
-      if (c == '/' && next == '*' && next2 == '*') {
-        state = DOC_STATE_CODE;
-        p--;
-      }
-      break;
+static bool doc_parser_sink(void *ctx, const lex_token_t *tok) {
+  doc_parser_t *dp = ctx;
+
+  str_slice_t body;
+  if (doc_comment_body(tok, &body)) {
+    /* 新的文档注释: 上一个若还没找到声明就丢弃 */
+    if (!string_init(&dp->comment, dp->alc, body.len + 1))
+      return false;
+    string_append_slice(&dp->comment, body);
+    dp->has_comment = true;
+    dp->in_signature = false;
+    return true;
+  }
+  if (!dp->has_comment)
+    return true;
+
+  const char *p = tok->text.ptr;
+  const char *end = tok->text.ptr + tok->text.len;
+  if (!dp->in_signature) {
+    p = skip_whitespace(p, end);
+    if (p == end)
+      return true;
+    if (!string_init(&dp->signature, dp->alc, 64))
+      return false;
+    dp->in_signature = true;
+  }
+
+  const char *from = p;
+  if (tok->kind == LEX_CODE || tok->kind == LEX_PREPROC) {
+    while (p < end && *p != '{' && *p != ';') {
+      p++;
     }
-    p++;
+  } else {
+    p = end;
   }
+  const char *to = p == end ? end : p + 1;
+  string_append_slice(&dp->signature,
+                      (str_slice_t){.ptr = from, .len = (size_t)(to - from)});
+  if (p == end)
+    return true;
+
+  doc_entry_t *entry = allocer_alloc(dp->alc, layout_of(doc_entry_t));
+  if (!entry)
+    return false;
+  entry->comment = string_as_slice(&dp->comment);
+  entry->signature = string_as_slice(&dp->signature);
+  if (!vec_push(dp->entries, (void *)entry))
+    return false;
+  dp->has_comment = false;
+  dp->in_signature = false;
+  return true;
+}
+
+static void parse_file_for_docs(allocer_t *alc, vec_t *entries_vec,
+                                str_slice_t file_content) {
+  doc_parser_t dp = {.alc = alc, .entries = entries_vec};
+  lexer_t lx;
+  lexer_init(&lx, scan_select(), file_content);
+
+  lex_token_t tok;
+  while (lexer_next(&lx, &tok)) {
+    if (!doc_parser_sink(&dp, &tok))
+      return;
+  }
+}
+
+/**
+ * @brief parse_file_for_docs 的流式版本, 按块读取 `fd`
+ */
+static bool parse_fd_for_docs(allocer_t *alc, vec_t *entries_vec, int fd) {
+  doc_parser_t dp = {.alc = alc, .entries = entries_vec};
+  return lex_stream_fd(alc, scan_select(), fd, LEX_STREAM_CHUNK,
+                       doc_parser_sink, &dp);
 }
 
 static str_slice_t slice_trim_whitespace_left(str_slice_t s) {
@@ -185,13 +234,203 @@ static void string_append_compact_slice(string_t *md, str_slice_t slice) {
   }
 }
 
+static bool slice_equal(str_slice_t a, str_slice_t b) {
+  return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+static bool is_ident_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+ * @brief 生成一个页面时用于交叉链接的上下文
+ */
+typedef struct {
+  const doc_symtab_t *symtab;
+  /* 正在生成的页面相对 `api/` 的路径, 以及其中的目录部分 (含 `/`) */
+  str_slice_t page;
+  str_slice_t dir;
+  /* 正在生成的条目的符号名, 不链接到它自己 */
+  str_slice_t self;
+} linker_t;
+
+/**
+ * @brief (辅助) 页面路径中的目录部分, 例如 `a_h/f.md` -> `a_h/`
+ */
+static str_slice_t page_dir(str_slice_t page) {
+  size_t len = page.len;
+  while (len > 0 && page.ptr[len - 1] != '/') {
+    len--;
+  }
+  return (str_slice_t){.ptr = page.ptr, .len = len};
+}
+
+/**
+ * @brief (辅助) 标识符 `ident` 应当链接到的符号, 没有时返回 NULL
+ */
+static const doc_symbol_t *link_target(const linker_t *lk,
+                                       str_slice_t ident) {
+  if (ident.ptr[0] >= '0' && ident.ptr[0] <= '9')
+    return NULL;
+  const doc_symbol_t *sym = doc_symtab_lookup(lk->symtab, ident);
+  if (!sym || (slice_equal(sym->name, lk->self) &&
+               slice_equal(sym->page, lk->page)))
+    return NULL;
+  return sym;
+}
+
+/**
+ * @brief (辅助) 追加符号的链接目标; 同一页面中的符号只需锚点
+ *
+ * 页面只在 `api/` 或它的一层子目录中, 相对路径最多需要一个 `../`。
+ */
+static void append_link_url(string_t *md, const linker_t *lk,
+                            const doc_symbol_t *sym) {
+  if (!slice_equal(sym->page, lk->page)) {
+    str_slice_t target = sym->page;
+    if (lk->dir.len > 0) {
+      if (target.len > lk->dir.len &&
+          memcmp(target.ptr, lk->dir.ptr, lk->dir.len) == 0) {
+        target.ptr += lk->dir.len;
+        target.len -= lk->dir.len;
+      } else {
+        string_append_cstr(md, "../");
+      }
+    }
+    string_append_slice(md, target);
+  }
+  string_push(md, '#');
+  string_append_slice(md, sym->name);
+}
+
+/**
+ * @brief 追加一段说明文字, 其中的已知符号写成 Markdown 链接
+ *
+ * 反引号中的代码原样保留。
+ */
+static void append_linked_text(string_t *md, const linker_t *lk,
+                               str_slice_t text) {
+  const char *p = text.ptr;
+  const char *end = text.ptr + text.len;
+  bool in_code = false;
+  while (p < end) {
+    if (*p == '`')
+      in_code = !in_code;
+    if (in_code || !is_ident_char(*p)) {
+      string_push(md, *p++);
+      continue;
+    }
+    const char *start = p;
+    while (p < end && is_ident_char(*p)) {
+      p++;
+    }
+    str_slice_t ident = {.ptr = start, .len = (size_t)(p - start)};
+    const doc_symbol_t *sym = link_target(lk, ident);
+    if (!sym) {
+      string_append_slice(md, ident);
+      continue;
+    }
+    string_push(md, '[');
+    string_append_slice(md, ident);
+    string_append_cstr(md, "](");
+    append_link_url(md, lk, sym);
+    string_push(md, ')');
+  }
+}
+
+/**
+ * @brief (辅助) 追加 HTML 转义后的文字
+ */
+static void append_html_escaped(string_t *md, str_slice_t text) {
+  for (size_t i = 0; i < text.len; i++) {
+    switch (text.ptr[i]) {
+    case '<':
+      string_append_cstr(md, "&lt;");
+      break;
+    case '>':
+      string_append_cstr(md, "&gt;");
+      break;
+    case '&':
+      string_append_cstr(md, "&amp;");
+      break;
+    default:
+      string_push(md, text.ptr[i]);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief 追加条目的标题
+ *
+ * 声明中没有可链接的符号时写成代码片段 "## `sig`"; 否则写成 HTML 的
+ * `<code>`, 因为 Markdown 的代码片段中不能有链接。
+ */
+static void append_heading(string_t *md, const linker_t *lk,
+                           str_slice_t signature) {
+  const char *p = signature.ptr;
+  const char *end = signature.ptr + signature.len;
+  bool has_link = false;
+  while (p < end && !has_link) {
+    if (!is_ident_char(*p)) {
+      p++;
+      continue;
+    }
+    const char *start = p;
+    while (p < end && is_ident_char(*p)) {
+      p++;
+    }
+    has_link = link_target(lk, (str_slice_t){.ptr = start,
+                                             .len = (size_t)(p - start)}) !=
+               NULL;
+  }
+
+  if (!has_link) {
+    string_append_cstr(md, "## `");
+    string_append_slice(md, signature);
+    string_append_cstr(md, "`\n\n");
+    return;
+  }
+
+  string_append_cstr(md, "## <code>");
+  p = signature.ptr;
+  while (p < end) {
+    const char *start = p;
+    if (!is_ident_char(*p)) {
+      while (p < end && !is_ident_char(*p)) {
+        p++;
+      }
+      append_html_escaped(md, (str_slice_t){.ptr = start,
+                                            .len = (size_t)(p - start)});
+      continue;
+    }
+    while (p < end && is_ident_char(*p)) {
+      p++;
+    }
+    str_slice_t ident = {.ptr = start, .len = (size_t)(p - start)};
+    const doc_symbol_t *sym = link_target(lk, ident);
+    if (!sym) {
+      string_append_slice(md, ident);
+      continue;
+    }
+    string_append_cstr(md, "<a href=\"");
+    append_link_url(md, lk, sym);
+    string_append_cstr(md, "\">");
+    string_append_slice(md, ident);
+    string_append_cstr(md, "</a>");
+  }
+  string_append_cstr(md, "</code>\n\n");
+}
+
 typedef enum {
   TAG_STATE_NONE,
   TAG_STATE_LIST,
   TAG_STATE_EXAMPLE
 } comment_parse_state_t;
 
-static void format_comment(string_t *md, str_slice_t comment) {
+static void format_comment(string_t *md, const linker_t *lk,
+                           str_slice_t comment) {
   const char *p = comment.ptr;
   const char *end = comment.ptr + comment.len;
   comment_parse_state_t state = TAG_STATE_NONE;
@@ -254,7 +493,7 @@ static void format_comment(string_t *md, str_slice_t comment) {
       string_append_cstr(md, "- **`");
       string_append_slice(md, name_slice);
       string_append_cstr(md, "`**: ");
-      string_append_slice(md, desc_slice);
+      append_linked_text(md, lk, desc_slice);
       string_push(md, '\n');
     } else if (slice_starts_with_lit(tag_body, "@return")) {
       if (state != TAG_STATE_LIST) {
@@ -265,7 +504,7 @@ static void format_comment(string_t *md, str_slice_t comment) {
       tag_body.len -= 7;
       tag_body = slice_trim_whitespace_left(tag_body);
       string_append_cstr(md, "- **Returns**: ");
-      string_append_slice(md, tag_body);
+      append_linked_text(md, lk, tag_body);
       string_push(md, '\n');
     } else if (slice_starts_with_lit(tag_body, "@note")) {
       state = TAG_STATE_NONE;
@@ -295,34 +534,161 @@ static void format_comment(string_t *md, str_slice_t comment) {
   }
 }
 
+bool doc_write_if_changed(allocer_t *alc, const char *path,
+                          str_slice_t bytes) {
+  struct stat st;
+  if (stat(path, &st) == 0 && (size_t)st.st_size == bytes.len) {
+    str_slice_t old;
+    if (read_file_to_slice(alc, path, &old) && old.len == bytes.len &&
+        memcmp(old.ptr, bytes.ptr, bytes.len) == 0)
+      return true;
+  }
+  return write_file_bytes(path, (const void *)bytes.ptr, bytes.len);
+}
+
+/**
+ * @brief 没有页面时记录在清单中的哈希 (空内容的哈希, 不为 0)
+ */
+static uint64_t no_page_hash(void) { return cache_hash("", 0); }
+
+
+/**
+ * @brief 追加一个条目: 锚点、标题与说明
+ *
+ * 符号表解析到的那个条目前放一个同名的锚点, 供其他页面链接;
+ * 同名的其他条目 (重复的声明、有歧义的符号) 不放, 页面中的 id 不会重复。
+ */
+static void append_entry(string_t *md, linker_t *lk, string_t *signature,
+                         const doc_entry_t *entry) {
+  if (!doc_entry_symbol(entry->signature, &lk->self))
+    lk->self = (str_slice_t){.ptr = NULL, .len = 0};
+  const doc_symbol_t *sym = doc_symtab_lookup(lk->symtab, lk->self);
+  if (sym && sym->entry == entry) {
+    string_append_cstr(md, "<a id=\"");
+    string_append_slice(md, lk->self);
+    string_append_cstr(md, "\"></a>\n\n");
+  }
+
+  string_clear(signature);
+  string_append_compact_slice(signature, entry->signature);
+  append_heading(md, lk, string_as_slice(signature));
+
+  format_comment(md, lk, entry->comment);
+}
+
+/**
+ * @brief 追加条目页面的标题: 符号名, 没有时为转义后的声明
+ */
+static void append_entry_title(string_t *out, string_t *scratch,
+                               const doc_entry_t *entry) {
+  str_slice_t name;
+  if (doc_entry_symbol(entry->signature, &name)) {
+    string_append_slice(out, name);
+    return;
+  }
+  string_clear(scratch);
+  string_append_compact_slice(scratch, entry->signature);
+  str_slice_t title = string_as_slice(scratch);
+  for (size_t i = 0; i < title.len; i++) {
+    if (strchr("\\`*_[]<>#", title.ptr[i]))
+      string_push(out, '\\');
+    string_push(out, title.ptr[i]);
+  }
+}
+
 /**
  * @brief [修改] 移除了 *Source: ...*
  */
-static bool generate_markdown_for_file(allocer_t *alc, vec_t *entries,
-                                       str_slice_t relative_path,
-                                       const char *md_file_path) {
-  string_t md;
+static bool generate_markdown_for_file(allocer_t *alc,
+                                       const doc_index_file_t *file,
+                                       const doc_symtab_t *symtab,
+                                       str_slice_t page_name,
+                                       const char *md_file_path,
+                                       uint64_t *page_hash) {
+  string_t md, signature;
   string_init(&md, alc, 4096);
+  string_init(&signature, alc, 256);
 
   string_append_cstr(&md, "# ");
-  string_append_slice(&md, relative_path);
+  string_append_slice(&md, file->relative_path);
   string_append_cstr(&md, "\n\n");
 
-  for (size_t i = 0; i < vec_count(entries); i++) {
-    doc_entry_t *entry = (void *)vec_get(entries, i);
-
-    string_append_cstr(&md, "## `");
-    string_append_compact_slice(&md, entry->signature);
-    string_append_cstr(&md, "`\n\n");
-
-    format_comment(&md, entry->comment);
+  linker_t lk = {.symtab = symtab, .page = page_name};
+  for (size_t i = 0; i < file->count; i++) {
+    append_entry(&md, &lk, &signature, &file->entries[i]);
     string_append_cstr(&md, "\n---\n\n");
   }
 
   str_slice_t md_slice = string_as_slice(&md);
-  bool ok =
-      write_file_bytes(md_file_path, (const void *)md_slice.ptr, md_slice.len);
+  *page_hash = cache_hash(md_slice.ptr, md_slice.len);
+  bool ok = doc_write_if_changed(alc, md_file_path, md_slice);
 
+  string_destroy(&signature);
+  string_destroy(&md);
+  return ok;
+}
+
+/**
+ * @brief 拆分后的页面: 源文件的页面只列出声明, 每个条目各成一页
+ *
+ * @param pages  doc_entry_pages 算出的各条目页面
+ */
+static bool generate_split_pages(allocer_t *alc, const char *api_out_dir,
+                                 const doc_index_file_t *file,
+                                 const doc_symtab_t *symtab,
+                                 str_slice_t page_name,
+                                 const str_slice_t *pages,
+                                 const char *md_file_path,
+                                 uint64_t *page_hash) {
+  string_t md, signature, path;
+  string_init(&md, alc, 4096);
+  string_init(&signature, alc, 256);
+  string_init(&path, alc, 256);
+
+  string_append_cstr(&md, "# ");
+  string_append_slice(&md, file->relative_path);
+  string_append_cstr(&md, "\n\n");
+  for (size_t i = 0; i < file->count; i++) {
+    string_clear(&signature);
+    string_append_compact_slice(&signature, file->entries[i].signature);
+    string_append_cstr(&md, "- [`");
+    string_append_slice(&md, string_as_slice(&signature));
+    string_append_cstr(&md, "`](");
+    string_append_slice(&md, pages[i]);
+    string_append_cstr(&md, ")\n");
+  }
+  str_slice_t md_slice = string_as_slice(&md);
+  *page_hash = cache_hash(md_slice.ptr, md_slice.len);
+  bool ok = doc_write_if_changed(alc, md_file_path, md_slice);
+
+  linker_t lk = {.symtab = symtab};
+  for (size_t i = 0; i < file->count && ok; i++) {
+    lk.page = pages[i];
+    lk.dir = page_dir(pages[i]);
+
+    string_clear(&md);
+    string_append_cstr(&md, "# ");
+    append_entry_title(&md, &signature, &file->entries[i]);
+    string_append_cstr(&md, "\n\nDefined in [`");
+    string_append_slice(&md, file->relative_path);
+    string_append_cstr(&md, "`](../");
+    string_append_slice(&md, page_name);
+    string_append_cstr(&md, ").\n\n");
+    append_entry(&md, &lk, &signature, &file->entries[i]);
+
+    string_clear(&path);
+    string_append_cstr(&path, api_out_dir);
+    if (api_out_dir[strlen(api_out_dir) - 1] != '/')
+      string_push(&path, '/');
+    string_append_slice(&path, pages[i]);
+
+    md_slice = string_as_slice(&md);
+    *page_hash = cache_hash_more(*page_hash, md_slice.ptr, md_slice.len);
+    ok = doc_write_if_changed(alc, string_as_cstr(&path), md_slice);
+  }
+
+  string_destroy(&path);
+  string_destroy(&signature);
   string_destroy(&md);
   return ok;
 }
@@ -339,149 +705,905 @@ static bool has_doc_extension(const char *filename) {
 }
 
 /**
- * @brief [重构] 遍历并立即处理文件
+ * @brief 一个待处理的源文件; 除路径、`stamp` 与 `cached_*` 外由工作线程填写
  */
-static void traverse_and_process(allocer_t *alc, const char *current_path,
-                                 const char *base_path, const char *api_out_dir,
-                                 string_t *summary_builder,
-                                 string_t *path_builder) {
-  DIR *dir = opendir(current_path);
-  if (!dir) {
-    fprintf(stderr, "Warning: Could not open directory '%s'\n", current_path);
-    return;
+typedef struct {
+  const char *full_path;
+  str_slice_t relative_path;
+  /* 提交前的 stat 元组 */
+  file_stamp_t stamp;
+  /* 清单中可复用的源文件哈希与页面哈希, 0 表示没有 */
+  uint64_t cached_hash;
+  uint64_t cached_page_hash;
+  /* 本次的源文件哈希 (0 表示未计算) 与页面哈希 (0 表示无法写入) */
+  uint64_t content_hash;
+  uint64_t page_hash;
+  /* 重新解析出的条目, 位于工作线程的 Arena 中 */
+  const doc_entry_t *entries;
+  size_t n_entries;
+  /* 是否交给了工作线程, 以及是否重新解析了它 */
+  bool submitted;
+  bool parsed;
+  bool ok;
+} doc_job_t;
+
+/**
+ * @brief 计算源文件对应页面的文件名与完整路径
+ */
+static void page_path_for(allocer_t *alc, const char *api_out_dir,
+                          str_slice_t relative_path, string_t *sanitized_name,
+                          string_t *md_path) {
+  string_init(sanitized_name, alc, relative_path.len + 4);
+  doc_page_name(relative_path, sanitized_name);
+
+  string_init(md_path, alc, 256);
+  string_append_cstr(md_path, api_out_dir);
+  if (api_out_dir[strlen(api_out_dir) - 1] != '/')
+    string_push(md_path, '/');
+  string_append_slice(md_path, string_as_slice(sanitized_name));
+}
+
+/**
+ * @brief (辅助) 追加一行 SUMMARY.md 条目
+ */
+static void append_summary_line(string_t *summary, const char *indent,
+                                str_slice_t title, str_slice_t page) {
+  string_append_cstr(summary, indent);
+  string_append_cstr(summary, "- [");
+  string_append_slice(summary, title);
+  string_append_cstr(summary, "](api/");
+  string_append_slice(summary, page);
+  string_append_cstr(summary, ")\n");
+}
+
+/**
+ * @brief 生成源文件在 SUMMARY.md 中的条目, 拆分后的页面嵌套在它之下
+ */
+static str_slice_t summary_entry_for(allocer_t *alc,
+                                     const doc_index_file_t *file,
+                                     size_t split_above) {
+  string_t summary, sanitized_name, title, scratch;
+  string_init(&summary, alc, 64);
+  string_init(&sanitized_name, alc, file->relative_path.len + 4);
+  doc_page_name(file->relative_path, &sanitized_name);
+  append_summary_line(&summary, "  ", file->relative_path,
+                      string_as_slice(&sanitized_name));
+  string_destroy(&sanitized_name);
+  if (!doc_page_is_split(file, split_above))
+    return string_as_slice(&summary);
+
+  str_slice_t *pages =
+      allocer_alloc(alc, layout_of_array(str_slice_t, file->count + 1));
+  if (!pages || !doc_entry_pages(alc, file, split_above, pages))
+    return string_as_slice(&summary);
+  string_init(&title, alc, 64);
+  string_init(&scratch, alc, 256);
+  for (size_t i = 0; i < file->count; i++) {
+    string_clear(&title);
+    append_entry_title(&title, &scratch, &file->entries[i]);
+    append_summary_line(&summary, "    ", string_as_slice(&title), pages[i]);
+  }
+  string_destroy(&scratch);
+  string_destroy(&title);
+  return string_as_slice(&summary);
+}
+
+bool doc_site_open(doc_site_t *site, allocer_t *alc, const char *out_dir) {
+  string_t api_dir_builder;
+  if (!string_init(&api_dir_builder, alc, 64))
+    return false;
+  if (!ensure_directory(out_dir))
+    return false;
+
+  string_append_cstr(&api_dir_builder, out_dir);
+  if (out_dir[strlen(out_dir) - 1] != '/')
+    string_push(&api_dir_builder, '/');
+  string_append_cstr(&api_dir_builder, "api");
+
+  site->out_dir = out_dir;
+  site->api_out_dir = string_as_cstr(&api_dir_builder);
+  site->split_above = 0;
+  return ensure_directory(site->api_out_dir);
+}
+
+static int slice_compare(const void *a, const void *b) {
+  const str_slice_t *x = a;
+  const str_slice_t *y = b;
+  size_t n = x->len < y->len ? x->len : y->len;
+  int cmp = memcmp(x->ptr, y->ptr, n);
+  if (cmp != 0)
+    return cmp;
+  return (x->len > y->len) - (x->len < y->len);
+}
+
+/**
+ * @brief 拆分后条目页面所在的目录: 页面路径去掉 `.md`
+ */
+static const char *split_dir_of(allocer_t *alc, string_t *md_path) {
+  str_slice_t md = string_as_slice(md_path);
+  string_t dir;
+  if (!string_init(&dir, alc, md.len))
+    return NULL;
+  string_append_slice(&dir, (str_slice_t){.ptr = md.ptr, .len = md.len - 3});
+  return string_as_cstr(&dir);
+}
+
+/**
+ * @brief 删除目录 `dir_path` 中不在 `keep` 里的条目页面, 不保留任何页面时
+ *        连同目录一起删除
+ *
+ * @param keep    要保留的页面相对 `api/` 的路径
+ * @param n_keep  `keep` 的个数
+ * @return 删除的页面数
+ */
+static size_t prune_entry_pages(allocer_t *alc, const char *dir_path,
+                                const str_slice_t *keep, size_t n_keep) {
+  DIR *dir = opendir(dir_path);
+  if (!dir)
+    return 0;
+  str_slice_t *names =
+      allocer_alloc(alc, layout_of_array(str_slice_t, n_keep + 1));
+  string_t path;
+  if (!names || !string_init(&path, alc, 256)) {
+    closedir(dir);
+    return 0;
+  }
+  for (size_t i = 0; i < n_keep; i++) {
+    str_slice_t prefix = page_dir(keep[i]);
+    names[i] = (str_slice_t){.ptr = keep[i].ptr + prefix.len,
+                             .len = keep[i].len - prefix.len};
   }
+  qsort(names, n_keep, sizeof(str_slice_t), slice_compare);
 
-  struct dirent *dp;
-  while ((dp = readdir(dir)) != NULL) {
-    const char *name = dp->d_name;
-    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+  size_t removed = 0;
+  struct dirent *de;
+  while ((de = readdir(dir)) != NULL) {
+    str_slice_t name = slice_from_cstr(de->d_name);
+    if (name.len < 4 || memcmp(name.ptr + name.len - 3, ".md", 3) != 0 ||
+        bsearch(&name, names, n_keep, sizeof(str_slice_t), slice_compare))
       continue;
+    string_clear(&path);
+    string_append_cstr(&path, dir_path);
+    string_push(&path, '/');
+    string_append_slice(&path, name);
+    if (unlink(string_as_cstr(&path)) == 0)
+      removed++;
+  }
+  closedir(dir);
+  if (n_keep == 0)
+    rmdir(dir_path);
+  string_destroy(&path);
+  return removed;
+}
+
+/**
+ * @brief 把一个源文件的条目写成页面; 没有条目时删除旧页面
+ *
+ * @param page_hash  接收所有页面的哈希, 无法写入时为 0
+ */
+static bool render_entries(const doc_site_t *site, allocer_t *alc,
+                           const doc_symtab_t *symtab,
+                           const doc_index_file_t *file, uint64_t *page_hash,
+                           report_t *rep) {
+  *page_hash = no_page_hash();
+  string_t sanitized_name, md_path;
+  page_path_for(alc, site->api_out_dir, file->relative_path, &sanitized_name,
+                &md_path);
+  const char *split_dir = split_dir_of(alc, &md_path);
+  bool split = doc_page_is_split(file, site->split_above);
+  str_slice_t *pages =
+      allocer_alloc(alc, layout_of_array(str_slice_t, file->count + 1));
+  if (!split_dir || !pages)
+    return false;
+
+  bool ok = true;
+  if (file->count == 0) {
+    /* 不再有文档注释的源文件: 删除上次生成的页面 */
+    unlink(string_as_cstr(&md_path));
+  } else if (split) {
+    ok = doc_entry_pages(alc, file, site->split_above, pages) &&
+         ensure_directory(split_dir) &&
+         generate_split_pages(alc, site->api_out_dir, file, symtab,
+                              string_as_slice(&sanitized_name), pages,
+                              string_as_cstr(&md_path), page_hash);
+  } else {
+    ok = generate_markdown_for_file(alc, file, symtab,
+                                    string_as_slice(&sanitized_name),
+                                    string_as_cstr(&md_path), page_hash);
+  }
+  if (!ok) {
+    report_err(rep, "Warning: Could not write file '%s'\n",
+               string_as_cstr(&md_path));
+    *page_hash = 0;
+  } else {
+    /* 不再拆分, 或拆分后少了条目: 删除多余的条目页面 */
+    prune_entry_pages(alc, split_dir, pages, split ? file->count : 0);
+  }
+
+  string_destroy(&md_path);
+  string_destroy(&sanitized_name);
+  return ok;
+}
+
+/**
+ * @brief (辅助) 把条目复制到 `alc` 中, 让它们活到页面生成之后
+ */
+static bool copy_entries(allocer_t *alc, vec_t *entries,
+                         doc_index_file_t *file) {
+  size_t n = vec_count(entries);
+  doc_entry_t *copies =
+      allocer_alloc(alc, layout_of_array(doc_entry_t, n + 1));
+  if (!copies)
+    return false;
+  for (size_t i = 0; i < n; i++) {
+    const doc_entry_t *entry = vec_get(entries, i);
+    char *copy = allocer_alloc(
+        alc, layout_of_array(char, entry->comment.len + entry->signature.len +
+                                       1));
+    if (!copy)
+      return false;
+    memcpy(copy, entry->comment.ptr, entry->comment.len);
+    memcpy(copy + entry->comment.len, entry->signature.ptr,
+           entry->signature.len);
+    copies[i].comment = (str_slice_t){.ptr = copy, .len = entry->comment.len};
+    copies[i].signature = (str_slice_t){.ptr = copy + entry->comment.len,
+                                        .len = entry->signature.len};
+  }
+  file->entries = copies;
+  file->count = n;
+  return true;
+}
+
+bool doc_site_parse(allocer_t *alc, allocer_t *entry_alc, str_slice_t content,
+                    doc_index_file_t *file) {
+  vec_t entries;
+  if (!vec_init(&entries, alc, 0))
+    return false;
+
+  parse_file_for_docs(alc, &entries, content);
+  bool ok = copy_entries(entry_alc, &entries, file);
+  vec_destroy(&entries);
+  return ok;
+}
 
-    string_clear(path_builder);
-    string_append_cstr(path_builder, current_path);
-    if (current_path[strlen(current_path) - 1] != '/')
-      string_push(path_builder, '/');
-    string_append_cstr(path_builder, name);
+/**
+ * @brief (辅助) 流式解析很大的源文件 `path`
+ */
+static bool parse_path_for_docs(allocer_t *alc, vec_t *entries_vec,
+                                const char *path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  bool ok = parse_fd_for_docs(alc, entries_vec, fd);
+  close(fd);
+  return ok;
+}
 
-    const char *full_path = string_as_cstr(path_builder);
+/**
+ * @brief SUMMARY.md 中一个源文件的条目
+ */
+typedef struct {
+  /* 源文件相对源目录的路径, 排序的依据 */
+  str_slice_t relative_path;
+  /* SUMMARY.md 中的一行 (含换行) */
+  str_slice_t entry;
+} doc_summary_item_t;
+
+static int compare_summary_item(const void *a, const void *b) {
+  const doc_summary_item_t *x = a;
+  const doc_summary_item_t *y = b;
+  return slice_compare(&x->relative_path, &y->relative_path);
+}
+
+/**
+ * @brief 按相对路径的字节序排好条目后写出 SUMMARY.md
+ *
+ * 排序不依赖区域设置, 同样的源码在任何机器上都生成逐字节相同的 SUMMARY.md。
+ */
+static bool write_summary(const doc_site_t *site, allocer_t *alc,
+                          doc_summary_item_t *items, size_t count) {
+  qsort(items, count, sizeof(doc_summary_item_t), compare_summary_item);
 
-    struct stat statbuf;
-    if (stat(full_path, &statbuf) != 0) {
-      fprintf(stderr, "Warning: Could not stat file '%s'\n", full_path);
+  string_t summary, path;
+  if (!string_init(&summary, alc, 1024) || !string_init(&path, alc, 256))
+    return false;
+
+  string_append_cstr(&summary, "# API Reference\n\n");
+  for (size_t i = 0; i < count; i++) {
+    string_append_slice(&summary, items[i].entry);
+  }
+
+  string_append_cstr(&path, site->out_dir);
+  if (site->out_dir[strlen(site->out_dir) - 1] != '/')
+    string_push(&path, '/');
+  string_append_cstr(&path, "SUMMARY.md");
+
+  bool ok = doc_write_if_changed(alc, string_as_cstr(&path),
+                             string_as_slice(&summary));
+  if (!ok)
+    fprintf(stderr, "Error: Failed to write '%s'\n", string_as_cstr(&path));
+
+  string_destroy(&path);
+  string_destroy(&summary);
+  return ok;
+}
+
+typedef struct {
+  const doc_site_t *site;
+  const doc_symtab_t *symtab;
+} render_ctx_t;
+
+/**
+ * @brief 一个待生成的页面; `page_hash` 由工作线程填写
+ */
+typedef struct {
+  const doc_index_file_t *file;
+  uint64_t page_hash;
+} render_job_t;
+
+/**
+ * @brief (工作线程) 生成单个源文件的页面
+ */
+static bool render_job(void *ctx, job_worker_t *worker, void *job,
+                       report_t *rep) {
+  render_ctx_t *rctx = ctx;
+  render_job_t *page = job;
+  return render_entries(rctx->site, &worker->scratch, rctx->symtab,
+                        page->file, &page->page_hash, rep);
+}
+
+bool doc_site_render_all(const doc_site_t *site, allocer_t *alc,
+                         const doc_index_file_t *files, size_t count,
+                         size_t jobs, uint64_t *page_hashes) {
+  doc_symtab_t symtab;
+  render_job_t *pages =
+      allocer_alloc(alc, layout_of_array(render_job_t, count + 1));
+  doc_summary_item_t *items =
+      allocer_alloc(alc, layout_of_array(doc_summary_item_t, count + 1));
+  if (!pages || !items ||
+      !doc_symtab_build(&symtab, alc, files, count, site->split_above))
+    return false;
+
+  render_ctx_t ctx = {.site = site, .symtab = &symtab};
+  job_pool_t pool;
+  if (!job_pool_init(&pool, alc, jobs, render_job, &ctx))
+    return false;
+  for (size_t i = 0; i < count; i++) {
+    pages[i].file = &files[i];
+    pages[i].page_hash = 0;
+    job_pool_submit(&pool, &pages[i]);
+  }
+  bool ok = job_pool_wait(&pool);
+  job_pool_destroy(&pool);
+
+  size_t n_items = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (page_hashes)
+      page_hashes[i] = pages[i].page_hash;
+    if (files[i].count == 0)
       continue;
+    items[n_items].relative_path = files[i].relative_path;
+    items[n_items].entry =
+        summary_entry_for(alc, &files[i], site->split_above);
+    n_items++;
+  }
+  return write_summary(site, alc, items, n_items) && ok;
+}
+
+static bool doc_job_run(job_worker_t *worker, doc_job_t *doc,
+                        report_t *rep) {
+  vec_t entries;
+  if (!vec_init(&entries, &worker->scratch, 0))
+    return false;
+
+  if (doc->stamp.size >= LEX_STREAM_MIN_SIZE) {
+    /* 很大的文件 (合并后的源码、生成的表格) 按块流式解析, 不计算哈希 */
+    if (!parse_path_for_docs(&worker->scratch, &entries, doc->full_path)) {
+      report_err(rep, "Warning: Could not read file '%s'\n", doc->full_path);
+      return false;
+    }
+  } else {
+    str_slice_t content;
+    if (!read_file_to_slice(&worker->scratch, doc->full_path, &content)) {
+      report_err(rep, "Warning: Could not read file '%s'\n", doc->full_path);
+      return false;
     }
 
-    if (S_ISDIR(statbuf.st_mode)) {
-      char *stable_path = allocer_strdup(alc, full_path);
-      if (stable_path) {
+    /* 只是被 touch 过: 内容与清单一致时沿用上次索引中的条目 */
+    doc->content_hash = cache_hash(content.ptr, content.len);
+    if (doc->content_hash == doc->cached_hash)
+      return true;
+    parse_file_for_docs(&worker->scratch, &entries, content);
+  }
 
-        traverse_and_process(alc, stable_path, base_path, api_out_dir,
-                             summary_builder, path_builder);
-      }
-    } else if (has_doc_extension(full_path)) {
+  /* 条目要活到页面生成之后, 不能放在 scratch 中 */
+  doc->parsed = true;
+  doc_index_file_t file;
+  bool ok = copy_entries(&worker->alc, &entries, &file);
+  doc->entries = file.entries;
+  doc->n_entries = file.count;
+  vec_destroy(&entries);
+  return ok;
+}
 
-      const char *relative_path_ptr = full_path + strlen(base_path);
-      if (relative_path_ptr[0] == '/')
-        relative_path_ptr++;
+/**
+ * @brief (工作线程) 解析单个文件, 取出它的条目
+ */
+static bool doc_job(void *ctx, job_worker_t *worker, void *job,
+                    report_t *rep) {
+  (void)ctx;
+  doc_job_t *doc = job;
+  doc->ok = doc_job_run(worker, doc, rep);
+  return doc->ok;
+}
 
-      char *stable_relative_path = allocer_strdup(alc, relative_path_ptr);
-      if (!stable_relative_path)
-        continue;
+typedef struct {
+  allocer_t *alc;
+  size_t base_len;
+  job_pool_t *pool;
+  vec_t *jobs;
+  /* 仅 --changed-since: 排好序的改动文件 (相对 src_dir) */
+  vec_t *changed;
+  const char **sorted_changed;
+  /* 上次运行的清单, 以及本次的解析版本与源目录的哈希 */
+  const cache_t *manifest;
+  uint64_t config_hash;
+  /* 上次的索引, 不重新解析的源文件从中取出条目 */
+  const doc_index_t *old_index;
+  /* 有子目录打不开或文件无法 stat: 本次没有看到完整的源文件列表 */
+  bool walk_error;
+} doc_walk_t;
 
-      str_slice_t relative_path_slice = slice_from_cstr(stable_relative_path);
+static int compare_cstr(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
 
-      str_slice_t content;
-      if (!read_file_to_slice(alc, full_path, &content)) {
-        fprintf(stderr, "Warning: Could not read file '%s'\n", full_path);
-        continue;
-      }
+/**
+ * @brief 在排好序的字符串数组中二分查找
+ */
+static bool sorted_contains(const char **sorted, size_t count,
+                            const char *s) {
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(sorted[mid], s);
+    if (cmp == 0)
+      return true;
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return false;
+}
 
-      vec_t entries;
-      if (!vec_init(&entries, alc, 0))
-        continue;
+/**
+ * @brief (辅助) 按清单判断源文件是否不必重新解析
+ *
+ * 记下清单中的哈希, 交给工作线程比较内容; stat 元组未变时返回 true。
+ */
+static bool reuse_from_manifest(doc_walk_t *walk, doc_job_t *doc) {
+  struct stat st;
+  if (stat(doc->full_path, &st) != 0)
+    return false;
+  file_stamp_from_stat(&st, &doc->stamp);
+
+  const cache_entry_t *entry =
+      cache_lookup(walk->manifest, doc->relative_path.ptr);
+  if (!entry || entry->style_hash != walk->config_hash || !entry->output_hash)
+    return false;
+  doc->cached_hash = entry->content_hash;
+  doc->cached_page_hash = entry->output_hash;
+  return file_stamp_equals(&entry->stamp, &doc->stamp);
+}
+
+/**
+ * @brief 上次的索引中没有该源文件的条目
+ */
+static bool entries_missing(const doc_walk_t *walk, const doc_job_t *doc) {
+  size_t index;
+  return !doc_index_find(walk->old_index, doc->relative_path, &index);
+}
+
+/**
+ * @brief --changed-since 回调: 收集改动的路径
+ */
+static bool collect_changed(void *ctx, const char *path) {
+  doc_walk_t *walk = ctx;
+  char *stable_path = allocer_strdup(walk->alc, path);
+  return stable_path && vec_push(walk->changed, stable_path);
+}
 
-      parse_file_for_docs(alc, &entries, content);
+/**
+ * @brief 遍历回调: 把需要重新解析的源文件作为任务提交给线程池
+ */
+static bool doc_visit(void *ctx, const walk_entry_t *entry) {
+  doc_walk_t *walk = ctx;
+  const char *full_path = entry->path.ptr;
 
-      if (vec_count(&entries) > 0) {
+  switch (entry->kind) {
+  case WALK_ERR_OPEN_DIR:
+    walk->walk_error = true;
+    job_pool_note(walk->pool, stderr,
+                  "Warning: Could not open directory '%s'\n", full_path);
+    return false;
+  case WALK_ERR_STAT:
+    walk->walk_error = true;
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat file '%s'\n",
+                  full_path);
+    return false;
+  case WALK_DIR:
+    return true;
+  default:
+    break;
+  }
 
-        string_t sanitized_name;
-        string_init(&sanitized_name, alc, relative_path_slice.len + 4);
+  if (entry->kind != WALK_FILE || !has_doc_extension(full_path))
+    return true;
 
-        sanitize_path_to_filename(relative_path_slice, &sanitized_name);
+  char *stable_full_path = allocer_strdup(walk->alc, full_path);
+  if (!stable_full_path)
+    return true;
 
-        string_clear(path_builder);
-        string_append_cstr(path_builder, api_out_dir);
-        if (api_out_dir[strlen(api_out_dir) - 1] != '/')
-          string_push(path_builder, '/');
-        string_append_slice(path_builder, string_as_slice(&sanitized_name));
-        const char *md_file_path = string_as_cstr(path_builder);
+  const char *relative_path_ptr = stable_full_path + walk->base_len;
+  if (relative_path_ptr[0] == '/')
+    relative_path_ptr++;
 
-        generate_markdown_for_file(alc, &entries, relative_path_slice,
-                                   md_file_path);
+  doc_job_t *doc = allocer_alloc(walk->alc, layout_of(doc_job_t));
+  if (!doc)
+    return true;
+  memset(doc, 0, sizeof(*doc));
+  doc->full_path = stable_full_path;
+  doc->relative_path = slice_from_cstr(relative_path_ptr);
 
-        string_append_cstr(summary_builder, "  - [");
-        string_append_slice(summary_builder, relative_path_slice);
-        string_append_cstr(summary_builder, "](api/");
-        string_append_slice(summary_builder, string_as_slice(&sanitized_name));
-        string_append_cstr(summary_builder, ")\n");
+  if (!vec_push(walk->jobs, doc))
+    return true;
+  bool reuse = reuse_from_manifest(walk, doc);
+  if (walk->changed)
+    reuse = !sorted_contains(walk->sorted_changed, vec_count(walk->changed),
+                             relative_path_ptr);
 
-        string_destroy(&sanitized_name);
-      }
+  /* 沿用的条目取自上次的索引: 索引中没有它时只能重新解析 */
+  if (entries_missing(walk, doc) &&
+      doc->cached_page_hash != no_page_hash()) {
+    doc->cached_hash = 0;
+    reuse = false;
+  }
+  if (!reuse) {
+    doc->submitted = true;
+    job_pool_submit(walk->pool, doc);
+  }
+  return true;
+}
+
+/**
+ * @brief 解析版本与源目录的哈希: 任一改变时清单中的记录全部作废
+ */
+static uint64_t doc_config_hash(const char *src_dir) {
+  uint64_t h = cache_hash(DOC_PARSE_VERSION, strlen(DOC_PARSE_VERSION));
+  return cache_hash_more(h, src_dir, strlen(src_dir));
+}
+
+/**
+ * @brief 交给了工作线程却失败的源文件: 既不生成页面也不写入索引
+ */
+static bool doc_failed(const doc_job_t *doc) {
+  return doc->submitted && !doc->ok;
+}
+
+/**
+ * @brief 更新清单, 并删除本次没有遍历到的源文件的页面
+ *
+ * @return 删除的页面数
+ */
+static size_t update_manifest(cache_t *manifest, allocer_t *alc,
+                              const doc_site_t *site, vec_t *doc_jobs,
+                              uint64_t config_hash) {
+  size_t n_jobs = vec_count(doc_jobs);
+  const char **seen =
+      allocer_alloc(alc, layout_of_array(const char *, n_jobs + 1));
+  if (!seen)
+    return 0;
 
-      vec_destroy(&entries);
+  for (size_t i = 0; i < n_jobs; i++) {
+    doc_job_t *doc = vec_get(doc_jobs, i);
+    const char *path = doc->relative_path.ptr;
+    seen[i] = path;
+    if (!doc->submitted)
+      continue;
+    if (doc->ok && doc->page_hash) {
+      cache_update(manifest, path, &doc->stamp, doc->content_hash,
+                   config_hash, 0, doc->page_hash);
+    } else {
+      cache_forget(manifest, path);
     }
   }
-  closedir(dir);
+  qsort(seen, n_jobs, sizeof(const char *), compare_cstr);
+
+  size_t removed = 0;
+  size_t iter = 0;
+  const cache_entry_t *entry;
+  while ((entry = cache_next(manifest, &iter)) != NULL) {
+    if (!entry->output_hash || sorted_contains(seen, n_jobs, entry->path))
+      continue;
+    /* 源文件已删除或不再被遍历: 它的页面也一并删除 */
+    if (entry->output_hash != no_page_hash()) {
+      string_t sanitized_name, md_path;
+      page_path_for(alc, site->api_out_dir, slice_from_cstr(entry->path),
+                    &sanitized_name, &md_path);
+      if (unlink(string_as_cstr(&md_path)) == 0)
+        removed++;
+      const char *split_dir = split_dir_of(alc, &md_path);
+      if (split_dir)
+        removed += prune_entry_pages(alc, split_dir, NULL, 0);
+      string_destroy(&md_path);
+      string_destroy(&sanitized_name);
+    }
+    cache_forget(manifest, entry->path);
+  }
+  return removed;
 }
 
-bool cnote_doc_run(allocer_t *alc, const char *src_dir, const char *out_dir) {
+/**
+ * @brief (辅助) `out_dir` 中文件 `name` 的路径
+ */
+static const char *out_file_path(allocer_t *alc, const char *out_dir,
+                                 const char *name) {
+  string_t path;
+  if (!string_init(&path, alc, 256))
+    return NULL;
+  string_append_cstr(&path, out_dir);
+  if (out_dir[strlen(out_dir) - 1] != '/')
+    string_push(&path, '/');
+  string_append_cstr(&path, name);
+  return string_as_cstr(&path);
+}
 
-  string_t path_builder;
-  string_t summary_builder;
-  string_t api_dir_builder;
+/**
+ * @brief (辅助) `out_dir` 中是否已有搜索索引
+ */
+static bool search_exists(allocer_t *alc, const char *out_dir) {
+  const char *meta =
+      out_file_path(alc, out_dir, DOC_SEARCH_DIR "/meta.json");
+  return meta && access(meta, F_OK) == 0;
+}
 
-  if (!string_init(&path_builder, alc, 256) ||
-      !string_init(&summary_builder, alc, 1024) ||
-      !string_init(&api_dir_builder, alc, 64)) {
+/**
+ * @brief (辅助) 取出索引中第 `index` 个源文件的全部条目
+ */
+static bool entries_from_index(allocer_t *alc, const doc_index_t *ix,
+                               size_t index, doc_index_file_t *file) {
+  size_t first;
+  doc_index_file(ix, index, &file->relative_path, &first, &file->count);
+  doc_entry_t *entries =
+      allocer_alloc(alc, layout_of_array(doc_entry_t, file->count + 1));
+  if (!entries)
     return false;
+  for (size_t k = 0; k < file->count; k++) {
+    doc_index_entry(ix, first + k, &entries[k]);
   }
+  file->entries = entries;
+  return true;
+}
 
-  if (!ensure_directory(out_dir))
+/**
+ * @brief 汇总所有源文件的条目: 重新解析的用新条目, 其余的取自上次的索引
+ *
+ * 失败的源文件不在其中, 其余按 `doc_jobs` 的顺序排列。
+ *
+ * @return 各源文件, 个数写入 `n_files`; 内存不足时为 NULL
+ */
+static doc_index_file_t *collect_files(allocer_t *alc, vec_t *doc_jobs,
+                                       const doc_index_t *old_index,
+                                       size_t *n_files) {
+  size_t n_jobs = vec_count(doc_jobs);
+  doc_index_file_t *files =
+      allocer_alloc(alc, layout_of_array(doc_index_file_t, n_jobs + 1));
+  if (!files)
+    return NULL;
+
+  *n_files = 0;
+  for (size_t i = 0; i < n_jobs; i++) {
+    doc_job_t *doc = vec_get(doc_jobs, i);
+    if (doc_failed(doc))
+      continue;
+    doc_index_file_t *file = &files[(*n_files)++];
+    file->relative_path = doc->relative_path;
+    file->entries = doc->entries;
+    file->count = doc->n_entries;
+
+    size_t index;
+    if (!doc->parsed &&
+        doc_index_find(old_index, doc->relative_path, &index) &&
+        !entries_from_index(alc, old_index, index, file))
+      return NULL;
+  }
+  return files;
+}
+
+/**
+ * @brief 写出索引与 (可选的) 搜索索引
+ */
+static bool write_indexes(allocer_t *alc, const char *out_dir,
+                          const char *index_path, bool searching,
+                          size_t split_above, doc_index_file_t *files,
+                          size_t n_files) {
+  if (!doc_index_write(alc, index_path, files, n_files)) {
+    fprintf(stderr, "Error: Failed to write '%s'\n", index_path);
     return false;
+  }
+  /* doc_index_write 已按路径排好序 */
+  if (searching &&
+      !doc_search_write(alc, out_dir, files, n_files, split_above)) {
+    fprintf(stderr, "Error: Failed to write the search index in '%s'\n",
+            out_dir);
+    return false;
+  }
+  return true;
+}
 
-  string_append_cstr(&api_dir_builder, out_dir);
-  if (out_dir[strlen(out_dir) - 1] != '/')
-    string_push(&api_dir_builder, '/');
-  string_append_cstr(&api_dir_builder, "api");
-  const char *api_out_dir = string_as_cstr(&api_dir_builder);
+bool cnote_doc_run(allocer_t *alc, const char *src_dir, const char *out_dir,
+                   const doc_opts_t *opts) {
+  doc_site_t site;
+  if (!doc_site_open(&site, alc, out_dir))
+    return false;
+  site.split_above = opts->split_above;
 
-  if (!ensure_directory(api_out_dir))
+  const char *manifest_path = out_file_path(alc, out_dir, DOC_MANIFEST_FILE);
+  const char *index_path = out_file_path(alc, out_dir, DOC_INDEX_FILE);
+  cache_t manifest;
+  if (!manifest_path || !index_path ||
+      !cache_load(&manifest, alc, manifest_path))
     return false;
 
-  string_append_cstr(&summary_builder, "# API Reference\n\n");
+  /* 索引缺失或损坏时为空: 所有有文档的源文件都会重新解析 */
+  doc_index_t old_index;
+  doc_index_open(&old_index, index_path);
+  /* 搜索索引一经写出, 之后的运行都会维护它 */
+  bool searching = opts->search || search_exists(alc, out_dir);
 
   printf("  Scanning `%s`...\n", src_dir);
   char *stable_src_dir = allocer_strdup(alc, src_dir);
   if (!stable_src_dir)
     return false;
 
-  traverse_and_process(alc, stable_src_dir, stable_src_dir, api_out_dir,
-                       &summary_builder, &path_builder);
+  vec_t doc_jobs;
+  if (!vec_init(&doc_jobs, alc, 0))
+    return false;
 
-  printf("  Writing SUMMARY.md to `%s`...\n", out_dir);
-  string_clear(&path_builder);
-  string_append_cstr(&path_builder, out_dir);
-  if (out_dir[strlen(out_dir) - 1] != '/')
-    string_push(&path_builder, '/');
-  string_append_cstr(&path_builder, "SUMMARY.md");
+  vec_t changed;
+  doc_walk_t walk = {
+      .alc = alc,
+      .base_len = strlen(stable_src_dir),
+      .jobs = &doc_jobs,
+      .changed = NULL,
+      .sorted_changed = NULL,
+      .manifest = &manifest,
+      .config_hash = doc_config_hash(stable_src_dir),
+      .old_index = &old_index,
+      .walk_error = false,
+  };
+  if (opts->changed_since) {
+    if (!vec_init(&changed, alc, 0))
+      return false;
+    walk.changed = &changed;
+    if (!git_changed_files(alc, opts->changed_since, stable_src_dir, NULL,
+                           collect_changed, &walk))
+      return false;
 
-  str_slice_t summary_slice = string_as_slice(&summary_builder);
-  write_file_bytes(string_as_cstr(&path_builder),
-                   (const void *)summary_slice.ptr, summary_slice.len);
+    size_t n_changed = vec_count(&changed);
+    walk.sorted_changed =
+        allocer_alloc(alc, layout_of_array(const char *, n_changed + 1));
+    if (!walk.sorted_changed)
+      return false;
+    for (size_t i = 0; i < n_changed; i++) {
+      walk.sorted_changed[i] = vec_get(&changed, i);
+    }
+    qsort(walk.sorted_changed, n_changed, sizeof(const char *), compare_cstr);
+  }
+
+  job_pool_t pool;
+  if (!job_pool_init(&pool, alc, opts->jobs, doc_job, NULL))
+    return false;
+  walk.pool = &pool;
 
-  string_destroy(&path_builder);
-  string_destroy(&summary_builder);
-  string_destroy(&api_dir_builder);
+  bool walk_ok = walk_tree(alc, stable_src_dir,
+                           opts->no_ignore ? WALK_NO_FLAGS : WALK_HONOR_IGNORE,
+                           doc_visit, &walk);
+  job_pool_wait(&pool);
 
-  return true;
-}
\ No newline at end of file
+  size_t n_jobs = vec_count(&doc_jobs);
+  size_t n_parsed = 0;
+  for (size_t i = 0; i < n_jobs; i++) {
+    doc_job_t *doc = vec_get(&doc_jobs, i);
+    if (doc->parsed)
+      n_parsed++;
+  }
+  printf("  %zu of %zu source(s) parsed.\n", n_parsed, n_jobs);
+
+  /* 页面互相链接: 每次都由全部条目重新生成, 但只写出有变化的 */
+  size_t n_files = 0;
+  doc_index_file_t *files =
+      collect_files(alc, &doc_jobs, &old_index, &n_files);
+  uint64_t *page_hashes =
+      allocer_alloc(alc, layout_of_array(uint64_t, n_jobs + 1));
+  if (!files || !page_hashes) {
+    doc_index_close(&old_index);
+    job_pool_destroy(&pool);
+    return false;
+  }
+  printf("  Writing pages and SUMMARY.md to `%s`...\n", out_dir);
+  bool ok = doc_site_render_all(&site, alc, files, n_files, opts->jobs,
+                                page_hashes);
+  for (size_t i = 0, k = 0; i < n_jobs; i++) {
+    doc_job_t *doc = vec_get(&doc_jobs, i);
+    if (!doc_failed(doc))
+      doc->page_hash = page_hashes[k++];
+  }
+
+  /* 遍历出错时不知道哪些源文件真的被删除了, 不清理页面也不重写索引 */
+  bool complete = walk_ok && !walk.walk_error;
+  if (!complete)
+    fprintf(stderr, "Warning: Source tree was not fully read; "
+                    "stale pages and the index are left as they were\n");
+  if (complete) {
+    size_t n_removed =
+        update_manifest(&manifest, alc, &site, &doc_jobs, walk.config_hash);
+    if (n_removed > 0)
+      printf("  %zu stale page(s) removed.\n", n_removed);
+  }
+  if (!cache_save(&manifest))
+    fprintf(stderr, "Warning: Could not write '%s'\n", manifest_path);
+  if (complete)
+    ok &= write_indexes(alc, out_dir, index_path, searching, site.split_above,
+                        files, n_files);
+
+  doc_index_close(&old_index);
+  job_pool_destroy(&pool);
+  vec_destroy(&doc_jobs);
+  return ok && complete;
+}
+
+bool cnote_doc_render_index(allocer_t *alc, const char *out_dir,
+                            const doc_opts_t *opts) {
+  doc_site_t site;
+  if (!doc_site_open(&site, alc, out_dir))
+    return false;
+  site.split_above = opts->split_above;
+  const char *index_path = out_file_path(alc, out_dir, DOC_INDEX_FILE);
+  if (!index_path)
+    return false;
+
+  doc_index_t index;
+  if (!doc_index_open(&index, index_path)) {
+    fprintf(stderr,
+            "Error: No valid doc index at '%s' (run 'cnote doc' first)\n",
+            index_path);
+    return false;
+  }
+
+  size_t n_files = index.n_files;
+  doc_index_file_t *files =
+      allocer_alloc(alc, layout_of_array(doc_index_file_t, n_files + 1));
+  bool ok = files != NULL;
+  for (size_t i = 0; i < n_files && ok; i++) {
+    ok = entries_from_index(alc, &index, i, &files[i]);
+  }
+  if (!ok) {
+    doc_index_close(&index);
+    return false;
+  }
+
+  printf("  Rendering %zu page(s) from `%s`...\n", n_files, index_path);
+  ok = doc_site_render_all(&site, alc, files, n_files, opts->jobs, NULL);
+
+  if ((opts->search || search_exists(alc, out_dir)) &&
+      !doc_search_write(alc, out_dir, files, n_files, site.split_above)) {
+    fprintf(stderr, "Error: Failed to write the search index in '%s'\n",
+            out_dir);
+    ok = false;
+  }
+
+  doc_index_close(&index);
+  return ok;
+}
@@ -0,0 +1,264 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <atomic_file.h>
+#include <doc_index.h>
+
+#include <core/mem/layout.h>
+#include <std/string/string.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DOC_INDEX_MAGIC "CNDOCIDX"
+#define DOC_INDEX_VERSION 1
+#define DOC_INDEX_HEADER_SIZE 32
+#define DOC_INDEX_RECORD_SIZE 16
+
+static void put_u32(unsigned char *p, uint32_t v) {
+  p[0] = (unsigned char)v;
+  p[1] = (unsigned char)(v >> 8);
+  p[2] = (unsigned char)(v >> 16);
+  p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static int compare_index_file(const void *a, const void *b) {
+  const doc_index_file_t *x = a;
+  const doc_index_file_t *y = b;
+  size_t n = x->relative_path.len < y->relative_path.len ? x->relative_path.len
+                                                         : y->relative_path.len;
+  int cmp = memcmp(x->relative_path.ptr, y->relative_path.ptr, n);
+  if (cmp != 0)
+    return cmp;
+  return (x->relative_path.len > y->relative_path.len) -
+         (x->relative_path.len < y->relative_path.len);
+}
+
+/**
+ * @brief (辅助) 追加一个字符串并写出它的偏移与长度
+ *
+ * @return false 字符串表超出 uint32 能表示的范围
+ */
+static bool put_string(string_t *strtab, unsigned char *rec, str_slice_t s) {
+  size_t off = string_as_slice(strtab).len;
+  if (off > UINT32_MAX || s.len > UINT32_MAX - off)
+    return false;
+  put_u32(rec, (uint32_t)off);
+  put_u32(rec + 4, (uint32_t)s.len);
+  string_append_slice(strtab, s);
+  return true;
+}
+
+bool doc_index_write(allocer_t *alc, const char *path, doc_index_file_t *files,
+                     size_t count) {
+  qsort(files, count, sizeof(doc_index_file_t), compare_index_file);
+
+  size_t n_files = 0, n_entries = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (files[i].count == 0)
+      continue;
+    n_files++;
+    n_entries += files[i].count;
+  }
+  if (n_files > UINT32_MAX || n_entries > UINT32_MAX)
+    return false;
+
+  size_t records_size =
+      DOC_INDEX_HEADER_SIZE + (n_files + n_entries) * DOC_INDEX_RECORD_SIZE;
+  unsigned char *records =
+      allocer_alloc(alc, layout_of_array(unsigned char, records_size));
+  string_t strtab;
+  if (!records || !string_init(&strtab, alc, 4096))
+    return false;
+
+  unsigned char *file_rec = records + DOC_INDEX_HEADER_SIZE;
+  unsigned char *entry_rec = file_rec + n_files * DOC_INDEX_RECORD_SIZE;
+  size_t next_entry = 0;
+  bool ok = true;
+  for (size_t i = 0; i < count && ok; i++) {
+    if (files[i].count == 0)
+      continue;
+    ok = put_string(&strtab, file_rec, files[i].relative_path);
+    put_u32(file_rec + 8, (uint32_t)next_entry);
+    put_u32(file_rec + 12, (uint32_t)files[i].count);
+    file_rec += DOC_INDEX_RECORD_SIZE;
+
+    for (size_t k = 0; k < files[i].count && ok; k++) {
+      const doc_entry_t *entry = &files[i].entries[k];
+      ok = put_string(&strtab, entry_rec, entry->signature) &&
+           put_string(&strtab, entry_rec + 8, entry->comment);
+      entry_rec += DOC_INDEX_RECORD_SIZE;
+    }
+    next_entry += files[i].count;
+  }
+  if (!ok) {
+    string_destroy(&strtab);
+    return false;
+  }
+
+  str_slice_t strings = string_as_slice(&strtab);
+  memset(records, 0, DOC_INDEX_HEADER_SIZE);
+  memcpy(records, DOC_INDEX_MAGIC, 8);
+  put_u32(records + 8, DOC_INDEX_VERSION);
+  put_u32(records + 12, (uint32_t)n_files);
+  put_u32(records + 16, (uint32_t)n_entries);
+  put_u32(records + 20, (uint32_t)strings.len);
+
+  atomic_file_t af;
+  if (!atomic_file_open(&af, alc, path)) {
+    atomic_file_abort(&af);
+    string_destroy(&strtab);
+    return false;
+  }
+  ok = atomic_file_write(&af, records, records_size) &&
+       atomic_file_write(&af, strings.ptr, strings.len);
+  if (ok) {
+    ok = atomic_file_commit(&af);
+  } else {
+    atomic_file_abort(&af);
+  }
+  string_destroy(&strtab);
+  return ok;
+}
+
+/**
+ * @brief (辅助) 记录中的 (偏移, 长度) 是否落在字符串表内
+ */
+static bool string_in_bounds(const unsigned char *rec, size_t strtab_size) {
+  size_t off = get_u32(rec);
+  size_t len = get_u32(rec + 4);
+  return off <= strtab_size && len <= strtab_size - off;
+}
+
+/**
+ * @brief (辅助) 校验所有记录, 之后的访问不再检查边界
+ */
+static bool validate(const doc_index_t *ix, size_t strtab_size) {
+  size_t next_entry = 0;
+  for (size_t i = 0; i < ix->n_files; i++) {
+    const unsigned char *rec = ix->files + i * DOC_INDEX_RECORD_SIZE;
+    if (!string_in_bounds(rec, strtab_size) || get_u32(rec + 8) != next_entry)
+      return false;
+    next_entry += get_u32(rec + 12);
+  }
+  if (next_entry != ix->n_entries)
+    return false;
+  for (size_t i = 0; i < ix->n_entries; i++) {
+    const unsigned char *rec = ix->entries + i * DOC_INDEX_RECORD_SIZE;
+    if (!string_in_bounds(rec, strtab_size) ||
+        !string_in_bounds(rec + 8, strtab_size))
+      return false;
+  }
+  return true;
+}
+
+bool doc_index_open(doc_index_t *ix, const char *path) {
+  memset(ix, 0, sizeof(*ix));
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < DOC_INDEX_HEADER_SIZE) {
+    close(fd);
+    return false;
+  }
+  void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    return false;
+  ix->base = base;
+  ix->size = (size_t)st.st_size;
+
+  const unsigned char *h = ix->base;
+  size_t n_files = get_u32(h + 12);
+  size_t n_entries = get_u32(h + 16);
+  size_t strtab_size = get_u32(h + 20);
+  size_t expected = DOC_INDEX_HEADER_SIZE +
+                    (n_files + n_entries) * DOC_INDEX_RECORD_SIZE + strtab_size;
+  if (memcmp(h, DOC_INDEX_MAGIC, 8) != 0 ||
+      get_u32(h + 8) != DOC_INDEX_VERSION || expected != ix->size) {
+    doc_index_close(ix);
+    return false;
+  }
+
+  ix->n_files = n_files;
+  ix->n_entries = n_entries;
+  ix->files = h + DOC_INDEX_HEADER_SIZE;
+  ix->entries = ix->files + n_files * DOC_INDEX_RECORD_SIZE;
+  ix->strtab = (const char *)(ix->entries + n_entries * DOC_INDEX_RECORD_SIZE);
+  if (!validate(ix, strtab_size)) {
+    doc_index_close(ix);
+    return false;
+  }
+  return true;
+}
+
+void doc_index_close(doc_index_t *ix) {
+  if (ix->base)
+    munmap((void *)ix->base, ix->size);
+  memset(ix, 0, sizeof(*ix));
+}
+
+static str_slice_t string_at(const doc_index_t *ix, const unsigned char *rec) {
+  return (str_slice_t){.ptr = ix->strtab + get_u32(rec),
+                       .len = get_u32(rec + 4)};
+}
+
+void doc_index_file(const doc_index_t *ix, size_t i, str_slice_t *relative_path,
+                    size_t *first_entry, size_t *n_entries) {
+  const unsigned char *rec = ix->files + i * DOC_INDEX_RECORD_SIZE;
+  *relative_path = string_at(ix, rec);
+  *first_entry = get_u32(rec + 8);
+  *n_entries = get_u32(rec + 12);
+}
+
+void doc_index_entry(const doc_index_t *ix, size_t i, doc_entry_t *entry) {
+  const unsigned char *rec = ix->entries + i * DOC_INDEX_RECORD_SIZE;
+  entry->signature = string_at(ix, rec);
+  entry->comment = string_at(ix, rec + 8);
+}
+
+bool doc_index_find(const doc_index_t *ix, str_slice_t relative_path,
+                    size_t *index) {
+  doc_index_file_t key = {.relative_path = relative_path};
+  size_t lo = 0, hi = ix->n_files;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const unsigned char *rec = ix->files + mid * DOC_INDEX_RECORD_SIZE;
+    doc_index_file_t probe = {.relative_path = string_at(ix, rec)};
+    int cmp = compare_index_file(&probe, &key);
+    if (cmp == 0) {
+      *index = mid;
+      return true;
+    }
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return false;
+}
@@ -0,0 +1,543 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <doc.h>
+#include <doc_search.h>
+#include <doc_xref.h>
+
+#include <core/mem/layout.h>
+#include <std/string/string.h>
+#include <std/vec.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* 没有符号名的条目以截断后的声明作为标题 */
+#define DOC_SEARCH_TITLE_MAX 60
+
+static bool is_ident_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief (辅助) 从 `p` 开始跳过空白后的标识符
+ */
+static str_slice_t ident_at(const char *p, const char *end) {
+  while (p < end && is_space(*p)) {
+    p++;
+  }
+  const char *q = p;
+  while (q < end && is_ident_char(*q)) {
+    q++;
+  }
+  return (str_slice_t){.ptr = p, .len = (size_t)(q - p)};
+}
+
+/**
+ * @brief (辅助) 紧挨在 `pos` 之前 (可隔着空白) 的标识符
+ */
+static str_slice_t ident_before(const char *start, const char *pos) {
+  while (pos > start && is_space(pos[-1])) {
+    pos--;
+  }
+  const char *q = pos;
+  while (q > start && is_ident_char(q[-1])) {
+    q--;
+  }
+  return (str_slice_t){.ptr = q, .len = (size_t)(pos - q)};
+}
+
+static bool slice_is(str_slice_t s, const char *lit) {
+  return s.len == strlen(lit) && memcmp(s.ptr, lit, s.len) == 0;
+}
+
+/**
+ * @brief 出现在声明结尾却不是名字的关键字, 例如 `typedef enum {`
+ */
+static bool is_keyword(str_slice_t s) {
+  static const char *const keywords[] = {
+      "struct", "union",    "enum",     "typedef", "const", "volatile",
+      "static", "extern",   "inline",   "signed",  "unsigned", "void",
+      "char",   "short",    "int",      "long",    "float",    "double",
+      "bool",   "restrict", "register",
+  };
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (slice_is(s, keywords[i]))
+      return true;
+  }
+  return false;
+}
+
+bool doc_entry_symbol(str_slice_t signature, str_slice_t *name) {
+  const char *p = signature.ptr;
+  const char *end = signature.ptr + signature.len;
+  while (p < end && is_space(*p)) {
+    p++;
+  }
+
+  str_slice_t id;
+  if (p < end && *p == '#') {
+    id = ident_at(p + 1, end);
+    if (!slice_is(id, "define"))
+      return false;
+    id = ident_at(id.ptr + id.len, end);
+  } else {
+    const char *paren = memchr(p, '(', (size_t)(end - p));
+    if (paren) {
+      const char *q = paren + 1;
+      while (q < end && is_space(*q)) {
+        q++;
+      }
+      /* `(*name)(...)`: 函数指针类型或变量 */
+      id = q < end && *q == '*' ? ident_at(q + 1, end) : ident_before(p, paren);
+    } else {
+      const char *stop = p;
+      while (stop < end && *stop != ';' && *stop != '{' && *stop != '=' &&
+             *stop != '[') {
+        stop++;
+      }
+      id = ident_before(p, stop);
+    }
+  }
+
+  if (id.len == 0 || (id.ptr[0] >= '0' && id.ptr[0] <= '9') || is_keyword(id))
+    return false;
+  *name = id;
+  return true;
+}
+
+/**
+ * @brief 一个 (词项, 条目) 对
+ */
+typedef struct {
+  /* 小写的词项 */
+  str_slice_t term;
+  uint32_t doc;
+} posting_t;
+
+/**
+ * @brief 搜索结果中的一个条目
+ */
+typedef struct {
+  str_slice_t url;
+  str_slice_t title;
+} search_doc_t;
+
+typedef struct {
+  allocer_t *alc;
+  vec_t *postings;
+  uint32_t doc;
+} term_sink_t;
+
+static bool add_term(term_sink_t *ts, const char *p, size_t len) {
+  if (len < 2)
+    return true;
+  posting_t *post = allocer_alloc(ts->alc, layout_of(posting_t));
+  char *term = allocer_alloc(ts->alc, layout_of_array(char, len));
+  if (!post || !term)
+    return false;
+  for (size_t i = 0; i < len; i++) {
+    char c = p[i];
+    term[i] = c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+  }
+  post->term = (str_slice_t){.ptr = term, .len = len};
+  post->doc = ts->doc;
+  return vec_push(ts->postings, post);
+}
+
+/**
+ * @brief (辅助) 加入一个标识符, 含 `_` 时再加入切开的各段
+ */
+static bool add_ident(term_sink_t *ts, const char *p, size_t len) {
+  if (!add_term(ts, p, len))
+    return false;
+  if (!memchr(p, '_', len))
+    return true;
+  const char *end = p + len;
+  while (p < end) {
+    const char *q = p;
+    while (q < end && *q != '_') {
+      q++;
+    }
+    if (!add_term(ts, p, (size_t)(q - p)))
+      return false;
+    p = q < end ? q + 1 : end;
+  }
+  return true;
+}
+
+/**
+ * @brief (辅助) 把文本切成词项: ASCII 标识符, 以及连续的非 ASCII 字节
+ */
+static bool add_words(term_sink_t *ts, str_slice_t text) {
+  const char *p = text.ptr;
+  const char *end = text.ptr + text.len;
+  while (p < end) {
+    const char *q = p;
+    if (is_ident_char(*p)) {
+      while (q < end && is_ident_char(*q)) {
+        q++;
+      }
+      if (!add_ident(ts, p, (size_t)(q - p)))
+        return false;
+    } else if ((unsigned char)*p >= 0x80) {
+      while (q < end && (unsigned char)*q >= 0x80) {
+        q++;
+      }
+      if (!add_term(ts, p, (size_t)(q - p)))
+        return false;
+    } else {
+      q++;
+    }
+    p = q;
+  }
+  return true;
+}
+
+/**
+ * @brief (辅助) 注释中 `@brief` 所在行的其余部分
+ */
+static str_slice_t brief_of(str_slice_t comment) {
+  const char *end = comment.ptr + comment.len;
+  for (const char *p = comment.ptr; p + 6 <= end; p++) {
+    if (memcmp(p, "@brief", 6) != 0)
+      continue;
+    const char *nl = memchr(p + 6, '\n', (size_t)(end - p - 6));
+    const char *line_end = nl ? nl : end;
+    return (str_slice_t){.ptr = p + 6, .len = (size_t)(line_end - p - 6)};
+  }
+  return (str_slice_t){.ptr = comment.ptr, .len = 0};
+}
+
+/**
+ * @brief (辅助) 折叠空白并截断的声明, 不在 UTF-8 字符中间截断
+ */
+static str_slice_t compact_title(allocer_t *alc, str_slice_t signature) {
+  string_t title;
+  if (!string_init(&title, alc, DOC_SEARCH_TITLE_MAX + 4))
+    return (str_slice_t){.ptr = "", .len = 0};
+  bool space = true;
+  for (size_t i = 0; i < signature.len; i++) {
+    char c = signature.ptr[i];
+    if (is_space(c)) {
+      space = true;
+      continue;
+    }
+    size_t len = string_as_slice(&title).len;
+    if (len >= DOC_SEARCH_TITLE_MAX && ((unsigned char)c & 0xC0) != 0x80) {
+      string_append_cstr(&title, "...");
+      break;
+    }
+    if (space && len > 0)
+      string_push(&title, ' ');
+    string_push(&title, c);
+    space = false;
+  }
+  return string_as_slice(&title);
+}
+
+static int compare_posting(const void *a, const void *b) {
+  const posting_t *x = *(const posting_t *const *)a;
+  const posting_t *y = *(const posting_t *const *)b;
+  size_t n = x->term.len < y->term.len ? x->term.len : y->term.len;
+  int cmp = memcmp(x->term.ptr, y->term.ptr, n);
+  if (cmp != 0)
+    return cmp;
+  if (x->term.len != y->term.len)
+    return x->term.len < y->term.len ? -1 : 1;
+  return (x->doc > y->doc) - (x->doc < y->doc);
+}
+
+static bool same_term(const posting_t *x, const posting_t *y) {
+  return x->term.len == y->term.len &&
+         memcmp(x->term.ptr, y->term.ptr, x->term.len) == 0;
+}
+
+static bool same_shard(const posting_t *x, const posting_t *y) {
+  return memcmp(x->term.ptr, y->term.ptr, DOC_SEARCH_PREFIX) == 0;
+}
+
+static void append_json_string(string_t *out, str_slice_t s) {
+  string_push(out, '"');
+  for (size_t i = 0; i < s.len; i++) {
+    unsigned char c = (unsigned char)s.ptr[i];
+    if (c == '"' || c == '\\') {
+      string_push(out, '\\');
+      string_push(out, (char)c);
+    } else if (c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      string_append_cstr(out, buf);
+    } else {
+      string_push(out, (char)c);
+    }
+  }
+  string_push(out, '"');
+}
+
+static void append_uint(string_t *out, size_t v) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%zu", v);
+  string_append_cstr(out, buf);
+}
+
+/**
+ * @brief (辅助) 收集所有条目及其词项
+ */
+static bool collect_postings(allocer_t *alc, const doc_index_file_t *files,
+                             size_t count, size_t split_above, vec_t *docs,
+                             vec_t *postings) {
+  term_sink_t ts = {.alc = alc, .postings = postings, .doc = 0};
+  for (size_t i = 0; i < count; i++) {
+    str_slice_t *pages =
+        allocer_alloc(alc, layout_of_array(str_slice_t, files[i].count + 1));
+    if (!pages || !doc_entry_pages(alc, &files[i], split_above, pages))
+      return false;
+
+    for (size_t k = 0; k < files[i].count; k++) {
+      const doc_entry_t *entry = &files[i].entries[k];
+      search_doc_t *doc = allocer_alloc(alc, layout_of(search_doc_t));
+      string_t url;
+      if (!doc || !string_init(&url, alc, pages[k].len + 5))
+        return false;
+      string_append_cstr(&url, "api/");
+      string_append_slice(&url, pages[k]);
+      doc->url = string_as_slice(&url);
+
+      str_slice_t symbol;
+      if (doc_entry_symbol(entry->signature, &symbol)) {
+        doc->title = symbol;
+        if (!add_words(&ts, symbol))
+          return false;
+      } else {
+        doc->title = compact_title(alc, entry->signature);
+      }
+      if (!add_words(&ts, brief_of(entry->comment)) || !vec_push(docs, doc))
+        return false;
+      ts.doc++;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief (辅助) 写出 postings[from, to) 组成的一个分片
+ *
+ * `local` 把全局条目号映射为分片内的编号, 调用前后都全为 UINT32_MAX。
+ */
+static bool write_shard(allocer_t *alc, const char *search_dir, vec_t *docs,
+                        posting_t **postings, size_t from, size_t to,
+                        uint32_t *local, const char *name) {
+  vec_t order;
+  if (!vec_init(&order, alc, 0))
+    return false;
+  for (size_t i = from; i < to; i++) {
+    uint32_t doc = postings[i]->doc;
+    if (local[doc] == UINT32_MAX) {
+      local[doc] = (uint32_t)vec_count(&order);
+      if (!vec_push(&order, vec_get(docs, doc)))
+        return false;
+    }
+  }
+
+  string_t json, path;
+  if (!string_init(&json, alc, 4096) || !string_init(&path, alc, 256))
+    return false;
+  string_append_cstr(&json, "{\"docs\":[");
+  for (size_t i = 0; i < vec_count(&order); i++) {
+    search_doc_t *doc = vec_get(&order, i);
+    string_append_cstr(&json, i ? ",[" : "[");
+    append_json_string(&json, doc->url);
+    string_push(&json, ',');
+    append_json_string(&json, doc->title);
+    string_push(&json, ']');
+  }
+  string_append_cstr(&json, "],\n\"terms\":[");
+  for (size_t i = from; i < to; i++) {
+    bool first = i == from || !same_term(postings[i - 1], postings[i]);
+    if (first) {
+      string_append_cstr(&json, i == from ? "[" : "]],\n[");
+      append_json_string(&json, postings[i]->term);
+      string_append_cstr(&json, ",[");
+    } else {
+      string_push(&json, ',');
+    }
+    append_uint(&json, local[postings[i]->doc]);
+  }
+  string_append_cstr(&json, "]]]}\n");
+
+  for (size_t i = from; i < to; i++) {
+    local[postings[i]->doc] = UINT32_MAX;
+  }
+
+  string_append_cstr(&path, search_dir);
+  string_push(&path, '/');
+  string_append_cstr(&path, name);
+  string_append_cstr(&path, ".json");
+  bool ok = doc_write_if_changed(alc, string_as_cstr(&path),
+                                 string_as_slice(&json));
+  string_destroy(&path);
+  string_destroy(&json);
+  vec_destroy(&order);
+  return ok;
+}
+
+static int compare_name(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/**
+ * @brief (辅助) 删除不再产出的分片
+ */
+static void remove_stale_shards(allocer_t *alc, const char *search_dir,
+                                const char **names, size_t n_names) {
+  DIR *dir = opendir(search_dir);
+  if (!dir)
+    return;
+  struct dirent *de;
+  while ((de = readdir(dir)) != NULL) {
+    size_t len = strlen(de->d_name);
+    if (len <= 5 || strcmp(de->d_name + len - 5, ".json") != 0 ||
+        strcmp(de->d_name, "meta.json") == 0)
+      continue;
+
+    char stem[NAME_MAX + 1];
+    memcpy(stem, de->d_name, len - 5);
+    stem[len - 5] = '\0';
+    const char *key = stem;
+    if (bsearch(&key, names, n_names, sizeof(const char *), compare_name))
+      continue;
+
+    string_t path;
+    if (!string_init(&path, alc, 256))
+      break;
+    string_append_cstr(&path, search_dir);
+    string_push(&path, '/');
+    string_append_cstr(&path, de->d_name);
+    unlink(string_as_cstr(&path));
+    string_destroy(&path);
+  }
+  closedir(dir);
+}
+
+bool doc_search_write(allocer_t *alc, const char *out_dir,
+                      const doc_index_file_t *files, size_t count,
+                      size_t split_above) {
+  string_t search_dir;
+  if (!string_init(&search_dir, alc, 256))
+    return false;
+  string_append_cstr(&search_dir, out_dir);
+  if (out_dir[strlen(out_dir) - 1] != '/')
+    string_push(&search_dir, '/');
+  string_append_cstr(&search_dir, DOC_SEARCH_DIR);
+  const char *dir = string_as_cstr(&search_dir);
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Failed to create directory: %s\n", dir);
+    return false;
+  }
+
+  vec_t docs, postings_vec;
+  if (!vec_init(&docs, alc, 0) || !vec_init(&postings_vec, alc, 0) ||
+      !collect_postings(alc, files, count, split_above, &docs,
+                        &postings_vec))
+    return false;
+
+  /* 排序后同一词项、同一分片的记录都相邻; 去掉重复的 (词项, 条目) */
+  size_t n = vec_count(&postings_vec);
+  posting_t **postings =
+      allocer_alloc(alc, layout_of_array(posting_t *, n + 1));
+  size_t n_docs = vec_count(&docs);
+  uint32_t *local = allocer_alloc(alc, layout_of_array(uint32_t, n_docs + 1));
+  if (!postings || !local)
+    return false;
+  for (size_t i = 0; i < n; i++) {
+    postings[i] = vec_get(&postings_vec, i);
+  }
+  qsort(postings, n, sizeof(posting_t *), compare_posting);
+  size_t unique = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (unique > 0 && same_term(postings[unique - 1], postings[i]) &&
+        postings[unique - 1]->doc == postings[i]->doc)
+      continue;
+    postings[unique++] = postings[i];
+  }
+  memset(local, 0xFF, (n_docs + 1) * sizeof(uint32_t));
+
+  const char **names =
+      allocer_alloc(alc, layout_of_array(const char *, unique + 1));
+  string_t meta;
+  if (!names || !string_init(&meta, alc, 1024))
+    return false;
+  string_append_cstr(&meta, "{\"version\":1,\"prefix\":");
+  append_uint(&meta, DOC_SEARCH_PREFIX);
+  string_append_cstr(&meta, ",\"docs\":");
+  append_uint(&meta, n_docs);
+  string_append_cstr(&meta, ",\"shards\":[");
+
+  bool ok = true;
+  size_t n_names = 0;
+  for (size_t from = 0; from < unique && ok;) {
+    size_t to = from + 1;
+    while (to < unique && same_shard(postings[from], postings[to])) {
+      to++;
+    }
+    char *name =
+        allocer_alloc(alc, layout_of_array(char, 2 * DOC_SEARCH_PREFIX + 1));
+    if (!name)
+      return false;
+    for (size_t i = 0; i < DOC_SEARCH_PREFIX; i++) {
+      snprintf(name + 2 * i, 3, "%02x",
+               (unsigned char)postings[from]->term.ptr[i]);
+    }
+    names[n_names++] = name;
+    if (n_names > 1)
+      string_push(&meta, ',');
+    append_json_string(&meta, slice_from_cstr(name));
+
+    ok = write_shard(alc, dir, &docs, postings, from, to, local, name);
+    from = to;
+  }
+  string_append_cstr(&meta, "]}\n");
+
+  if (ok) {
+    string_t meta_path;
+    if (!string_init(&meta_path, alc, 256))
+      return false;
+    string_append_cstr(&meta_path, dir);
+    string_append_cstr(&meta_path, "/meta.json");
+    ok = doc_write_if_changed(alc, string_as_cstr(&meta_path),
+                              string_as_slice(&meta));
+    remove_stale_shards(alc, dir, names, n_names);
+    string_destroy(&meta_path);
+  }
+
+  string_destroy(&meta);
+  vec_destroy(&postings_vec);
+  vec_destroy(&docs);
+  return ok;
+}
@@ -0,0 +1,183 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <cache.h>
+#include <doc.h>
+#include <doc_search.h>
+#include <doc_xref.h>
+
+#include <core/mem/layout.h>
+#include <std/string/string.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define DOC_SYMTAB_MIN_CAP 16
+
+static bool slice_equal(str_slice_t a, str_slice_t b) {
+  return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+static bool is_header(str_slice_t relative_path) {
+  return relative_path.len >= 2 &&
+         memcmp(relative_path.ptr + relative_path.len - 2, ".h", 2) == 0;
+}
+
+/**
+ * @brief (辅助) `name` 所在的槽位: 已有的记录或应当插入的空槽
+ */
+static doc_symbol_t *find_slot(const doc_symtab_t *tab, str_slice_t name) {
+  size_t mask = tab->cap - 1;
+  size_t i = (size_t)cache_hash(name.ptr, name.len) & mask;
+  while (tab->slots[i].name.ptr && !slice_equal(tab->slots[i].name, name)) {
+    i = (i + 1) & mask;
+  }
+  return &tab->slots[i];
+}
+
+/**
+ * @brief (辅助) 分配容纳 `n` 个符号的空表
+ */
+static bool symtab_init(doc_symtab_t *tab, allocer_t *alc, size_t n) {
+  size_t cap = DOC_SYMTAB_MIN_CAP;
+  while (cap < n * 2) {
+    cap *= 2;
+  }
+  tab->cap = cap;
+  tab->slots = allocer_alloc(alc, layout_of_array(doc_symbol_t, cap));
+  if (!tab->slots)
+    return false;
+  memset(tab->slots, 0, cap * sizeof(doc_symbol_t));
+  return true;
+}
+
+bool doc_page_is_split(const doc_index_file_t *file, size_t split_above) {
+  if (split_above == 0)
+    return false;
+  size_t bytes = 0;
+  for (size_t k = 0; k < file->count; k++) {
+    bytes += file->entries[k].signature.len + file->entries[k].comment.len;
+  }
+  return bytes > split_above;
+}
+
+bool doc_entry_pages(allocer_t *alc, const doc_index_file_t *file,
+                     size_t split_above, str_slice_t *pages) {
+  string_t page;
+  if (!string_init(&page, alc, file->relative_path.len + 4))
+    return false;
+  doc_page_name(file->relative_path, &page);
+  str_slice_t file_page = string_as_slice(&page);
+  if (!doc_page_is_split(file, split_above)) {
+    for (size_t k = 0; k < file->count; k++) {
+      pages[k] = file_page;
+    }
+    return true;
+  }
+
+  /* 拆分后的目录即页面名去掉 `.md`; 用一张临时的表找出重复的符号名 */
+  str_slice_t dir = {.ptr = file_page.ptr, .len = file_page.len - 3};
+  doc_symtab_t seen;
+  if (!symtab_init(&seen, alc, file->count))
+    return false;
+  for (size_t k = 0; k < file->count; k++) {
+    string_t path;
+    if (!string_init(&path, alc, dir.len + 32))
+      return false;
+    string_append_slice(&path, dir);
+    string_push(&path, '/');
+
+    str_slice_t name;
+    doc_symbol_t *slot = NULL;
+    if (doc_entry_symbol(file->entries[k].signature, &name)) {
+      slot = find_slot(&seen, name);
+      if (slot->name.ptr)
+        slot = NULL;
+    }
+    if (slot) {
+      slot->name = name;
+      string_append_slice(&path, name);
+    } else {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "entry-%zu", k + 1);
+      string_append_cstr(&path, buf);
+    }
+    string_append_cstr(&path, ".md");
+    pages[k] = string_as_slice(&path);
+  }
+  return true;
+}
+
+/**
+ * @brief (辅助) 加入一个定义, 按优先级决定保留、替换还是标记歧义
+ */
+static void insert(doc_symtab_t *tab, str_slice_t name, str_slice_t page,
+                   const doc_index_file_t *file, const doc_entry_t *entry,
+                   bool from_header) {
+  doc_symbol_t *slot = find_slot(tab, name);
+  if (!slot->name.ptr || (from_header && !slot->from_header)) {
+    *slot = (doc_symbol_t){.name = name,
+                           .page = page,
+                           .file = file,
+                           .entry = entry,
+                           .from_header = from_header,
+                           .ambiguous = false};
+    return;
+  }
+  if (from_header == slot->from_header && slot->file != file)
+    slot->ambiguous = true;
+}
+
+bool doc_symtab_build(doc_symtab_t *tab, allocer_t *alc,
+                      const doc_index_file_t *files, size_t count,
+                      size_t split_above) {
+  size_t n_entries = 0, max_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    n_entries += files[i].count;
+    if (files[i].count > max_count)
+      max_count = files[i].count;
+  }
+  str_slice_t *pages =
+      allocer_alloc(alc, layout_of_array(str_slice_t, max_count + 1));
+  if (!pages || !symtab_init(tab, alc, n_entries))
+    return false;
+
+  for (size_t i = 0; i < count; i++) {
+    if (files[i].count == 0)
+      continue;
+    if (!doc_entry_pages(alc, &files[i], split_above, pages))
+      return false;
+    bool from_header = is_header(files[i].relative_path);
+
+    for (size_t k = 0; k < files[i].count; k++) {
+      str_slice_t name;
+      if (doc_entry_symbol(files[i].entries[k].signature, &name))
+        insert(tab, name, pages[k], &files[i], &files[i].entries[k],
+               from_header);
+    }
+  }
+  return true;
+}
+
+const doc_symbol_t *doc_symtab_lookup(const doc_symtab_t *tab,
+                                      str_slice_t name) {
+  if (tab->cap == 0 || name.len == 0)
+    return NULL;
+  const doc_symbol_t *slot = find_slot(tab, name);
+  if (!slot->name.ptr || slot->ambiguous)
+    return NULL;
+  return slot;
+}
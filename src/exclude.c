@@ -0,0 +1,199 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <exclude.h>
+
+#include <core/mem/layout.h>
+
+#include <fnmatch.h>
+#include <string.h>
+
+static bool is_glob(const char *pattern) {
+  return strpbrk(pattern, "*?[") != NULL;
+}
+
+/**
+ * @brief (辅助) 构建子串模式的 Aho-Corasick 自动机
+ *
+ * 先建 trie, 再按 BFS 顺序补全失配转移, 得到无需回溯的 DFA。
+ * 字节先映射为字节类, 只有出现在模式中的字节拥有独立的列。
+ */
+static bool build_automaton(exclude_set_t *set, allocer_t *alc,
+                            vec_t *substrings) {
+  size_t n = vec_count(substrings);
+  size_t max_states = 1;
+
+  memset(set->byte_class, 0, sizeof(set->byte_class));
+  set->n_classes = 1;
+  for (size_t i = 0; i < n; i++) {
+    size_t idx = (size_t)vec_get(substrings, i);
+    const unsigned char *p = vec_get(&set->patterns, idx);
+    for (; *p; p++) {
+      if (set->byte_class[*p] == 0)
+        set->byte_class[*p] = (uint8_t)set->n_classes++;
+      max_states++;
+    }
+  }
+
+  size_t nc = set->n_classes;
+  set->delta = allocer_alloc(alc, layout_of_array(int32_t, max_states * nc));
+  set->out = allocer_alloc(alc, layout_of_array(int32_t, max_states));
+  int32_t *fail = allocer_alloc(alc, layout_of_array(int32_t, max_states));
+  int32_t *queue = allocer_alloc(alc, layout_of_array(int32_t, max_states));
+  if (!set->delta || !set->out || !fail || !queue)
+    return false;
+  for (size_t i = 0; i < max_states * nc; i++)
+    set->delta[i] = -1;
+  for (size_t i = 0; i < max_states; i++)
+    set->out[i] = -1;
+
+  set->n_states = 1;
+  for (size_t i = 0; i < n; i++) {
+    size_t idx = (size_t)vec_get(substrings, i);
+    const unsigned char *p = vec_get(&set->patterns, idx);
+    int32_t s = 0;
+    for (; *p; p++) {
+      int32_t *next = &set->delta[(size_t)s * nc + set->byte_class[*p]];
+      if (*next < 0)
+        *next = (int32_t)set->n_states++;
+      s = *next;
+    }
+    if (set->out[s] < 0)
+      set->out[s] = (int32_t)idx;
+  }
+
+  size_t head = 0, tail = 0;
+  for (size_t c = 0; c < nc; c++) {
+    int32_t *next = &set->delta[c];
+    if (*next < 0) {
+      *next = 0;
+    } else {
+      fail[*next] = 0;
+      queue[tail++] = *next;
+    }
+  }
+  while (head < tail) {
+    int32_t s = queue[head++];
+    if (set->out[s] < 0)
+      set->out[s] = set->out[fail[s]];
+    for (size_t c = 0; c < nc; c++) {
+      int32_t *next = &set->delta[(size_t)s * nc + c];
+      int32_t via_fail = set->delta[(size_t)fail[s] * nc + c];
+      if (*next < 0) {
+        *next = via_fail;
+      } else {
+        fail[*next] = via_fail;
+        queue[tail++] = *next;
+      }
+    }
+  }
+  return true;
+}
+
+bool exclude_set_init(exclude_set_t *set, allocer_t *alc, vec_t *patterns) {
+  memset(set, 0, sizeof(*set));
+  size_t n = vec_count(patterns);
+
+  vec_t substrings;
+  if (!vec_init(&set->patterns, alc, n) || !vec_init(&set->prefixes, alc, 0) ||
+      !vec_init(&set->globs, alc, 0) || !vec_init(&substrings, alc, n))
+    return false;
+
+  for (size_t i = 0; i < n; i++) {
+    const char *pattern = vec_get(patterns, i);
+    if (!vec_push(&set->patterns, (void *)pattern))
+      return false;
+    if (pattern[0] == '\0')
+      continue;
+
+    vec_t *kind = &substrings;
+    if (pattern[0] == '^')
+      kind = &set->prefixes;
+    else if (is_glob(pattern))
+      kind = &set->globs;
+    if (!vec_push(kind, (void *)i))
+      return false;
+  }
+
+  bool ok = build_automaton(set, alc, &substrings);
+  vec_destroy(&substrings);
+  return ok;
+}
+
+/**
+ * @brief (辅助) 用自动机扫描 `path`, 返回第一个命中的子串模式下标
+ */
+static int32_t scan_substrings(const exclude_set_t *set, str_slice_t path) {
+  const unsigned char *p = (const unsigned char *)path.ptr;
+  const unsigned char *end = p + path.len;
+  size_t nc = set->n_classes;
+  int32_t s = 0;
+  for (; p < end; p++) {
+    s = set->delta[(size_t)s * nc + set->byte_class[*p]];
+    if (set->out[s] >= 0)
+      return set->out[s];
+  }
+  return -1;
+}
+
+const char *exclude_match(const exclude_set_t *set, str_slice_t path,
+                          bool is_dir) {
+  if (vec_count(&set->patterns) == 0)
+    return NULL;
+
+  /* 目录以 `path/` 的形式参与匹配 */
+  char stack_buf[4096];
+  str_slice_t subject = path;
+  if (is_dir && path.len + 2 <= sizeof(stack_buf) &&
+      (path.len == 0 || path.ptr[path.len - 1] != '/')) {
+    memcpy(stack_buf, path.ptr, path.len);
+    stack_buf[path.len] = '/';
+    stack_buf[path.len + 1] = '\0';
+    subject = (str_slice_t){.ptr = stack_buf, .len = path.len + 1};
+  }
+
+  int32_t hit = scan_substrings(set, subject);
+  if (hit >= 0)
+    return vec_get(&set->patterns, (size_t)hit);
+
+  for (size_t i = 0; i < vec_count(&set->prefixes); i++) {
+    const char *pattern =
+        vec_get(&set->patterns, (size_t)vec_get(&set->prefixes, i));
+    size_t len = strlen(pattern + 1);
+    if (len <= subject.len && memcmp(subject.ptr, pattern + 1, len) == 0)
+      return pattern;
+  }
+
+  if (vec_count(&set->globs) == 0)
+    return NULL;
+
+  /* fnmatch 需要以 NUL 结尾的字符串; walker 与 targets 的路径本身即是 */
+  const char *full = subject.ptr;
+  const char *base = path.ptr;
+  for (size_t i = 0; i < path.len; i++) {
+    if (path.ptr[i] == '/' && i + 1 < path.len)
+      base = path.ptr + i + 1;
+  }
+  for (size_t i = 0; i < vec_count(&set->globs); i++) {
+    const char *pattern =
+        vec_get(&set->patterns, (size_t)vec_get(&set->globs, i));
+    if (fnmatch(pattern, full, 0) == 0)
+      return pattern;
+    if (!strchr(pattern, '/') && fnmatch(pattern, base, 0) == 0)
+      return pattern;
+  }
+  return NULL;
+}
@@ -0,0 +1,128 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <git_changed.h>
+
+#include <core/mem/layout.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+#define GIT_MAX_FIXED_ARGS 12
+
+/**
+ * @brief (辅助) 运行一条 git 命令, 把它的 stdout 当作路径列表读取
+ */
+static bool run_git_list(allocer_t *alc, const char *what, const char **fixed,
+                         size_t n_fixed, vec_t *pathspecs, path_list_fn_t fn,
+                         void *ctx) {
+  size_t n_specs = pathspecs ? vec_count(pathspecs) : 0;
+  char **argv =
+      allocer_alloc(alc, layout_of_array(char *, n_fixed + n_specs + 2));
+  if (!argv)
+    return false;
+  size_t argc = 0;
+  for (size_t i = 0; i < n_fixed; i++) {
+    argv[argc++] = (char *)fixed[i];
+  }
+  argv[argc++] = "--";
+  for (size_t i = 0; i < n_specs; i++) {
+    argv[argc++] = (char *)vec_get(pathspecs, i);
+  }
+  argv[argc] = NULL;
+
+  int out_pipe[2];
+  if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+    fprintf(stderr, "Error: pipe() failed: %s\n", strerror(errno));
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, "git", &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(out_pipe[1]);
+
+  if (err != 0) {
+    fprintf(stderr, "Error: Could not run git (%s)\n", strerror(err));
+    close(out_pipe[0]);
+    return false;
+  }
+
+  bool read_ok = path_list_read_fd(alc, out_pipe[0], "git", fn, ctx);
+  close(out_pipe[0]);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      status = -1;
+      break;
+    }
+  }
+  if (!read_ok)
+    return false;
+  if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "Error: 'git %s' failed\n", what);
+    return false;
+  }
+  return true;
+}
+
+bool git_changed_files(allocer_t *alc, const char *rev, const char *dir,
+                       vec_t *pathspecs, path_list_fn_t fn, void *ctx) {
+  if (rev[0] == '-' || rev[0] == '\0') {
+    fprintf(stderr, "Error: Invalid revision '%s'\n", rev);
+    return false;
+  }
+
+  const char *args[GIT_MAX_FIXED_ARGS];
+  size_t n = 0;
+  args[n++] = "git";
+  if (dir) {
+    args[n++] = "-C";
+    args[n++] = dir;
+  }
+  size_t base = n;
+
+  args[n++] = "diff";
+  args[n++] = "--name-only";
+  args[n++] = "-z";
+  args[n++] = "--relative";
+  args[n++] = "--diff-filter=d";
+  /* 子模块以 gitlink 的形式出现, 不属于要处理的源文件 */
+  args[n++] = "--ignore-submodules";
+  args[n++] = rev;
+  if (!run_git_list(alc, "diff", args, n, pathspecs, fn, ctx))
+    return false;
+
+  n = base;
+  args[n++] = "ls-files";
+  args[n++] = "-z";
+  args[n++] = "--others";
+  args[n++] = "--exclude-standard";
+  return run_git_list(alc, "ls-files", args, n, pathspecs, fn, ctx);
+}
@@ -0,0 +1,362 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <ignore.h>
+
+#include <core/mem/layout.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IGNORE_MAX_FILE_SIZE (4 * 1024 * 1024)
+
+/**
+ * @brief gitignore 风格的 glob 匹配
+ *
+ * `*` 与 `?` 不跨越 `/`; `**` 后接 `/` 时匹配零或多级目录,
+ * 位于末尾时匹配剩余的一切; 支持 `[...]` 字符类与 `\` 转义。
+ */
+static bool glob_match(const char *p, const char *pe, const char *s,
+                       const char *se) {
+  while (p < pe) {
+    char c = *p;
+    if (c == '*') {
+      if (p + 1 < pe && p[1] == '*') {
+        const char *rest = p + 2;
+        if (rest == pe)
+          return true;
+        if (*rest == '/') {
+          rest++;
+          for (const char *t = s;;) {
+            if (glob_match(rest, pe, t, se))
+              return true;
+            const char *slash = memchr(t, '/', (size_t)(se - t));
+            if (!slash)
+              return false;
+            t = slash + 1;
+          }
+        }
+      }
+      while (p < pe && *p == '*')
+        p++;
+      for (const char *t = s;; t++) {
+        if (glob_match(p, pe, t, se))
+          return true;
+        if (t == se || *t == '/')
+          return false;
+      }
+    }
+
+    if (s == se)
+      return false;
+
+    if (c == '?') {
+      if (*s == '/')
+        return false;
+      p++;
+      s++;
+      continue;
+    }
+
+    if (c == '[') {
+      const char *q = p + 1;
+      bool negate = q < pe && (*q == '!' || *q == '^');
+      if (negate)
+        q++;
+      bool matched = false;
+      const char *class_start = q;
+      while (q < pe && (*q != ']' || q == class_start)) {
+        char lo = *q++;
+        char hi = lo;
+        if (q + 1 < pe && *q == '-' && q[1] != ']') {
+          hi = q[1];
+          q += 2;
+        }
+        if ((unsigned char)*s >= (unsigned char)lo &&
+            (unsigned char)*s <= (unsigned char)hi)
+          matched = true;
+      }
+      if (q < pe) {
+        if (*s == '/' || matched == negate)
+          return false;
+        p = q + 1;
+        s++;
+        continue;
+      }
+      /* 没有闭合的 `]`: 按字面量处理 */
+    }
+
+    if (c == '\\' && p + 1 < pe)
+      c = *++p;
+    if (*s != c)
+      return false;
+    p++;
+    s++;
+  }
+  return s == se;
+}
+
+/**
+ * @brief (辅助) 解析一行规则, 空行与注释返回 false
+ */
+static bool parse_rule(const char *line, size_t len, ignore_rule_t *rule) {
+  if (len > 0 && line[len - 1] == '\r')
+    len--;
+  if (len == 0 || line[0] == '#')
+    return false;
+  while (len > 0 && line[len - 1] == ' ' &&
+         !(len >= 2 && line[len - 2] == '\\'))
+    len--;
+
+  memset(rule, 0, sizeof(*rule));
+  if (line[0] == '!') {
+    rule->negate = true;
+    line++;
+    len--;
+  } else if (len >= 2 && line[0] == '\\' &&
+             (line[1] == '!' || line[1] == '#')) {
+    line++;
+    len--;
+  }
+  if (len > 0 && line[len - 1] == '/') {
+    rule->dir_only = true;
+    len--;
+  }
+  if (memchr(line, '/', len)) {
+    rule->anchored = true;
+    if (line[0] == '/') {
+      line++;
+      len--;
+    }
+  }
+  if (len == 0)
+    return false;
+
+  rule->pattern = line;
+  rule->len = len;
+  return true;
+}
+
+/**
+ * @brief (辅助) 读取 `dir_fd` 下的规则文件并追加到 `rules`; 文件不存在时忽略
+ */
+static bool load_rules(allocer_t *alc, int dir_fd, const char *name,
+                       vec_t *rules) {
+  int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return true;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size > IGNORE_MAX_FILE_SIZE) {
+    close(fd);
+    return true;
+  }
+
+  size_t size = (size_t)st.st_size;
+  char *text = allocer_alloc(alc, layout_of_array(char, size + 1));
+  if (!text) {
+    close(fd);
+    return false;
+  }
+  size_t got = 0;
+  while (got < size) {
+    ssize_t n = read(fd, text + got, size - got);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    got += (size_t)n;
+  }
+  close(fd);
+
+  const char *p = text;
+  const char *end = text + got;
+  while (p < end) {
+    const char *line_end = memchr(p, '\n', (size_t)(end - p));
+    if (!line_end)
+      line_end = end;
+    ignore_rule_t parsed;
+    if (parse_rule(p, (size_t)(line_end - p), &parsed)) {
+      ignore_rule_t *rule = allocer_alloc(alc, layout_of(ignore_rule_t));
+      if (!rule || !vec_push(rules, rule))
+        return false;
+      *rule = parsed;
+    }
+    p = line_end + 1;
+  }
+  return true;
+}
+
+static ignore_level_t *push_level(ignore_stack_t *st, size_t base_len) {
+  if (st->depth == st->cap) {
+    size_t new_cap = st->cap ? st->cap * 2 : 32;
+    ignore_level_t *new_levels =
+        allocer_alloc(st->alc, layout_of_array(ignore_level_t, new_cap));
+    if (!new_levels)
+      return NULL;
+    if (st->depth)
+      memcpy(new_levels, st->levels, st->depth * sizeof(ignore_level_t));
+    st->levels = new_levels;
+    st->cap = new_cap;
+  }
+  ignore_level_t *level = &st->levels[st->depth];
+  if (!vec_init(&level->rules, st->alc, 0))
+    return NULL;
+  level->base_len = base_len;
+  st->depth++;
+  return level;
+}
+
+/**
+ * @brief (辅助) 加载 `root` 之上直到仓库顶层的各级 .gitignore
+ *
+ * 从 realpath(root) 向上寻找含有 `.git` 的目录; 找不到时不加载任何规则。
+ */
+static bool load_parents(ignore_stack_t *st, const char *root) {
+  char *abs_root = realpath(root, NULL);
+  if (!abs_root)
+    return true;
+
+  size_t top_len = strlen(abs_root);
+  bool found = false;
+  for (;;) {
+    char probe[PATH_MAX];
+    int n = snprintf(probe, sizeof(probe), "%.*s/.git", (int)top_len,
+                     abs_root);
+    if (n > 0 && (size_t)n < sizeof(probe) && access(probe, F_OK) == 0) {
+      found = true;
+      break;
+    }
+    while (top_len > 0 && abs_root[top_len - 1] != '/')
+      top_len--;
+    if (top_len <= 1)
+      break;
+    top_len--;
+  }
+  if (!found || abs_root[top_len] == '\0') {
+    free(abs_root);
+    return true;
+  }
+
+  /* root_prefix: 起点相对顶层的路径, 如 "include/sub/" */
+  string_append_cstr(&st->root_prefix, abs_root + top_len + 1);
+  string_push(&st->root_prefix, '/');
+
+  bool ok = true;
+  str_slice_t prefix = string_as_slice(&st->root_prefix);
+  for (size_t i = 0; ok && i < prefix.len; i++) {
+    if (i != 0 && prefix.ptr[i - 1] != '/')
+      continue;
+    char dir_path[PATH_MAX];
+    int n = snprintf(dir_path, sizeof(dir_path), "%.*s/%.*s", (int)top_len,
+                     abs_root, (int)i, prefix.ptr);
+    if (n < 0 || (size_t)n >= sizeof(dir_path))
+      continue;
+    int dir_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+      continue;
+    ignore_level_t *level = push_level(st, i);
+    ok = level != NULL;
+    if (ok && i == 0)
+      ok = load_rules(st->alc, dir_fd, ".git/info/exclude", &level->rules);
+    if (ok)
+      ok = load_rules(st->alc, dir_fd, ".gitignore", &level->rules) &&
+           load_rules(st->alc, dir_fd, ".ignore", &level->rules);
+    close(dir_fd);
+  }
+  st->n_parents = st->depth;
+  free(abs_root);
+  return ok;
+}
+
+bool ignore_stack_init(ignore_stack_t *st, allocer_t *alc, const char *root) {
+  memset(st, 0, sizeof(*st));
+  st->alc = alc;
+  if (!string_init(&st->root_prefix, alc, 64) ||
+      !string_init(&st->scratch, alc, 256))
+    return false;
+  return load_parents(st, root);
+}
+
+bool ignore_stack_push_dir(ignore_stack_t *st, int dir_fd,
+                           str_slice_t rel_dir) {
+  size_t base_len = string_as_slice(&st->root_prefix).len + rel_dir.len;
+  ignore_level_t *level = push_level(st, base_len);
+  if (!level)
+    return false;
+  /* 起点就是仓库顶层 (或不在仓库中) 时, 由这里加载 .git/info/exclude */
+  if (st->n_parents == 0 && st->depth == 1 &&
+      !load_rules(st->alc, dir_fd, ".git/info/exclude", &level->rules))
+    return false;
+  return load_rules(st->alc, dir_fd, ".gitignore", &level->rules) &&
+         load_rules(st->alc, dir_fd, ".ignore", &level->rules);
+}
+
+void ignore_stack_pop(ignore_stack_t *st) {
+  if (st->depth > st->n_parents)
+    st->depth--;
+}
+
+static bool rule_matches(const ignore_rule_t *rule, str_slice_t subject,
+                         bool is_dir) {
+  if (rule->dir_only && !is_dir)
+    return false;
+  const char *s = subject.ptr;
+  const char *se = subject.ptr + subject.len;
+  if (!rule->anchored) {
+    const char *slash = memrchr(s, '/', subject.len);
+    if (slash)
+      s = slash + 1;
+  }
+  return glob_match(rule->pattern, rule->pattern + rule->len, s, se);
+}
+
+bool ignore_stack_match(ignore_stack_t *st, str_slice_t rel_path,
+                        bool is_dir) {
+  str_slice_t prefix = string_as_slice(&st->root_prefix);
+  str_slice_t full = rel_path;
+  if (st->n_parents > 0) {
+    string_clear(&st->scratch);
+    string_append_slice(&st->scratch, prefix);
+    string_append_slice(&st->scratch, rel_path);
+    full = string_as_slice(&st->scratch);
+  }
+
+  for (size_t i = st->depth; i-- > 0;) {
+    const ignore_level_t *level = &st->levels[i];
+    size_t skip = level->base_len;
+    if (st->n_parents == 0)
+      skip -= prefix.len;
+    if (skip > full.len)
+      continue;
+    str_slice_t subject = {.ptr = full.ptr + skip, .len = full.len - skip};
+
+    for (size_t j = vec_count(&level->rules); j-- > 0;) {
+      const ignore_rule_t *rule = vec_get(&level->rules, j);
+      if (rule_matches(rule, subject, is_dir))
+        return !rule->negate;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,290 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <lex.h>
+
+#include <core/mem/layout.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+void lexer_init(lexer_t *lx, scan_fn_t find, str_slice_t src) {
+  lx->find = find;
+  lx->start = src.ptr;
+  lx->p = src.ptr;
+  lx->end = src.ptr + src.len;
+  lx->in_directive = false;
+  lx->more = false;
+  lx->line_blank = true;
+  /* `#` 只在行首才开始指令; 指令内部改为查找结尾的换行 */
+  scan_set_init(&lx->code_set, "/\"'#");
+  scan_set_init(&lx->directive_set, "/\"'\n");
+  scan_set_init(&lx->string_set, "\"\\\n");
+  scan_set_init(&lx->char_set, "'\\\n");
+}
+
+static bool emit(lexer_t *lx, lex_token_t *tok, lex_kind_t kind,
+                 const char *to, bool terminated) {
+  tok->kind = kind;
+  tok->text = (str_slice_t){.ptr = lx->p, .len = (size_t)(to - lx->p)};
+  tok->terminated = terminated;
+  lx->p = to;
+  return true;
+}
+
+/**
+ * @brief 换行符 `nl` 之前是否紧跟反斜杠 (续行)
+ */
+static bool is_escaped_newline(const lexer_t *lx, const char *nl) {
+  const char *q = nl;
+  if (q > lx->start && q[-1] == '\r')
+    q--;
+  return q > lx->start && q[-1] == '\\';
+}
+
+/**
+ * @brief `pos` 之前直到行首是否只有空白; 是则返回行首, 否则返回 NULL
+ *
+ * 流式时缓冲区开头不一定是行首, 越过它之后由 `line_blank` 决定。
+ */
+static const char *blank_line_start(const lexer_t *lx, const char *pos) {
+  const char *q = pos;
+  while (q > lx->start && (q[-1] == ' ' || q[-1] == '\t')) {
+    q--;
+  }
+  if (q == lx->start)
+    return lx->line_blank ? q : NULL;
+  if (q[-1] == '\n')
+    return q;
+  return NULL;
+}
+
+/**
+ * @brief (流式) 代码片段跨过块尾时, 在最后一个换行之后切开
+ *
+ * 指令中的换行都已确认是续行, 切开后 in_directive 保持不变。
+ */
+static bool lex_code_partial(lexer_t *lx, lex_token_t *tok) {
+  const char *q = lx->end;
+  while (q > lx->p && q[-1] != '\n') {
+    q--;
+  }
+  /* 一行还没读完: 不产出, 等待更多输入 */
+  if (q == lx->p)
+    return false;
+  return emit(lx, tok, lx->in_directive ? LEX_PREPROC : LEX_CODE, q, true);
+}
+
+static bool lex_code(lexer_t *lx, lex_token_t *tok) {
+  const char *p = lx->p;
+  const char *end = lx->end;
+  const char *q = p;
+
+  for (;;) {
+    const scan_set_t *set =
+        lx->in_directive ? &lx->directive_set : &lx->code_set;
+    const char *hit = lx->find(q, end, set);
+    if (hit == end)
+      break;
+
+    if (*hit == '\n') {
+      /* 只在指令中查找换行 */
+      if (is_escaped_newline(lx, hit)) {
+        q = hit + 1;
+        continue;
+      }
+      lx->in_directive = false;
+      return emit(lx, tok, LEX_PREPROC, hit + 1, true);
+    }
+    if (*hit == '#') {
+      const char *line_start = blank_line_start(lx, hit);
+      if (line_start && line_start > p)
+        return emit(lx, tok, LEX_CODE, line_start, true);
+      if (line_start)
+        lx->in_directive = true;
+      q = hit + 1;
+      continue;
+    }
+    if (*hit == '/') {
+      if (hit + 1 == end && lx->more)
+        break;
+      char next = hit + 1 < end ? hit[1] : '\0';
+      if (next != '/' && next != '*') {
+        q = hit + 1;
+        continue;
+      }
+    }
+    /* 注释或字面量从 hit 开始; lexer_next 保证 hit > p */
+    return emit(lx, tok, lx->in_directive ? LEX_PREPROC : LEX_CODE, hit, true);
+  }
+  if (lx->more)
+    return lex_code_partial(lx, tok);
+  return emit(lx, tok, lx->in_directive ? LEX_PREPROC : LEX_CODE, end, true);
+}
+
+static bool lex_line_comment(lexer_t *lx, lex_token_t *tok) {
+  const char *q = lx->p + 2;
+  for (;;) {
+    const char *nl = memchr(q, '\n', (size_t)(lx->end - q));
+    if (!nl) {
+      if (lx->more)
+        return false;
+      return emit(lx, tok, LEX_LINE_COMMENT, lx->end, true);
+    }
+    if (!is_escaped_newline(lx, nl))
+      return emit(lx, tok, LEX_LINE_COMMENT, nl, true);
+    q = nl + 1;
+  }
+}
+
+static bool lex_block_comment(lexer_t *lx, lex_token_t *tok) {
+  const char *q = lx->p + 2;
+  for (;;) {
+    const char *star = memchr(q, '*', (size_t)(lx->end - q));
+    if (!star) {
+      if (lx->more)
+        return false;
+      return emit(lx, tok, LEX_BLOCK_COMMENT, lx->end, false);
+    }
+    if (star + 1 < lx->end && star[1] == '/')
+      return emit(lx, tok, LEX_BLOCK_COMMENT, star + 2, true);
+    q = star + 1;
+  }
+}
+
+static bool lex_literal(lexer_t *lx, lex_token_t *tok, lex_kind_t kind,
+                        const scan_set_t *set) {
+  const char quote = *lx->p;
+  const char *end = lx->end;
+  const char *q = lx->p + 1;
+  for (;;) {
+    const char *hit = lx->find(q, end, set);
+    if (hit == end) {
+      if (lx->more)
+        return false;
+      return emit(lx, tok, kind, end, false);
+    }
+    if (*hit == quote)
+      return emit(lx, tok, kind, hit + 1, true);
+    if (*hit == '\n')
+      return emit(lx, tok, kind, hit, false);
+    /* 反斜杠: 跳过被转义的字节, `\` + CRLF 一并跳过 */
+    q = hit + 2;
+    if (q < end && hit[1] == '\r' && *q == '\n')
+      q++;
+    if (q > end)
+      q = end;
+    /* 流式时 `\` + CR 之后的 LF 可能还在下一块 */
+    if (q == end && lx->more)
+      return false;
+  }
+}
+
+bool lexer_next(lexer_t *lx, lex_token_t *tok) {
+  if (lx->p >= lx->end)
+    return false;
+
+  char c = *lx->p;
+  if (c == '/' && lx->p + 1 == lx->end && lx->more)
+    return false;
+  char next = lx->p + 1 < lx->end ? lx->p[1] : '\0';
+  if (c == '/' && next == '/')
+    return lex_line_comment(lx, tok);
+  if (c == '/' && next == '*')
+    return lex_block_comment(lx, tok);
+  if (c == '"')
+    return lex_literal(lx, tok, LEX_STRING, &lx->string_set);
+  if (c == '\'')
+    return lex_literal(lx, tok, LEX_CHAR, &lx->char_set);
+
+  /* 跨块时整个片段会重新切分, 先记下进入前的状态 */
+  bool in_directive = lx->in_directive;
+  if (lex_code(lx, tok))
+    return true;
+  lx->in_directive = in_directive;
+  return false;
+}
+
+/* 搬到缓冲区开头的回看字节数: is_escaped_newline 最多回看两个字节 */
+#define LEX_STREAM_LOOKBEHIND 2
+
+/**
+ * @brief 读入最多 `len` 字节, 遇到 EINTR 重试
+ *
+ * @return 读到的字节数, 0 表示文件结束, -1 表示出错
+ */
+static ssize_t read_some(int fd, char *buf, size_t len) {
+  for (;;) {
+    ssize_t n = read(fd, buf, len);
+    if (n >= 0 || errno != EINTR)
+      return n;
+  }
+}
+
+bool lex_stream_fd(allocer_t *alc, scan_fn_t find, int fd, size_t chunk,
+                   lex_sink_fn sink, void *ctx) {
+  size_t cap = chunk * 2;
+  char *buf = allocer_alloc(alc, layout_of_array(char, cap));
+  if (!buf)
+    return false;
+
+  lexer_t lx;
+  lexer_init(&lx, find, (str_slice_t){.ptr = buf, .len = 0});
+  lx.more = true;
+
+  for (;;) {
+    /* 保留未切分的尾部与其前面的少量回看字节 */
+    const char *keep = lx.p;
+    for (int i = 0; i < LEX_STREAM_LOOKBEHIND && keep > lx.start; i++) {
+      keep--;
+    }
+    bool line_blank = blank_line_start(&lx, keep) != NULL;
+    size_t lookbehind = (size_t)(lx.p - keep);
+    size_t carry = (size_t)(lx.end - keep);
+
+    if (carry + chunk > cap) {
+      /* 单个片段比块还长: 扩大缓冲区, 旧的留在 Arena 中 */
+      size_t new_cap = (carry + chunk) * 2;
+      char *new_buf = allocer_alloc(alc, layout_of_array(char, new_cap));
+      if (!new_buf)
+        return false;
+      memcpy(new_buf, keep, carry);
+      buf = new_buf;
+      cap = new_cap;
+    } else {
+      memmove(buf, keep, carry);
+    }
+
+    ssize_t n = read_some(fd, buf + carry, chunk);
+    if (n < 0)
+      return false;
+
+    lx.start = buf;
+    lx.p = buf + lookbehind;
+    lx.end = buf + carry + (size_t)n;
+    lx.line_blank = line_blank;
+    lx.more = n > 0;
+
+    lex_token_t tok;
+    while (lexer_next(&lx, &tok)) {
+      if (!sink(ctx, &tok))
+        return false;
+    }
+    if (!lx.more)
+      return true;
+  }
+}
@@ -16,7 +16,18 @@
 
 
 
+#define _GNU_SOURCE
+#include <atomic_file.h>
+#include <cache.h>
+#include <exclude.h>
+#include <git_changed.h>
+#include <lex.h>
 #include <license.h>
+#include <path_list.h>
+#include <pool.h>
+#include <report.h>
+#include <stdio_filter.h>
+#include <walk.h>
 
 #include <core/mem/layout.h>
 #include <core/msg/asrt.h>
@@ -29,7 +40,8 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -46,28 +58,6 @@ static inline char *allocer_strdup(allocer_t *alc, const char *s) {
   return new_s;
 }
 
-static bool slice_starts_with_slice(str_slice_t s, str_slice_t prefix) {
-  if (prefix.len > s.len)
-    return false;
-  return memcmp(s.ptr, prefix.ptr, prefix.len) == 0;
-}
-
-static bool slice_starts_with_lit(str_slice_t s, const char *lit) {
-  size_t lit_len = strlen(lit);
-  if (lit_len > s.len)
-    return false;
-  return strncmp(s.ptr, lit, lit_len) == 0;
-}
-
-static ssize_t find_first_block_comment_end(str_slice_t s) {
-  for (size_t i = 0; i + 1 < s.len; i++) {
-    if (s.ptr[i] == '*' && s.ptr[i + 1] == '/') {
-      return (ssize_t)i;
-    }
-  }
-  return -1;
-}
-
 static const char *skip_whitespace(const char *p, const char *end) {
   while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
     p++;
@@ -109,172 +99,594 @@ static bool is_licensable_file(const char *filename) {
   return false;
 }
 
-static bool apply_license_to_file(allocer_t *alc, const char *filepath,
-                                  str_slice_t golden_header_slice) {
+typedef struct {
+  str_slice_t golden_header;
+  const license_opts_t *opts;
+} license_ctx_t;
 
-  str_slice_t file_content;
-  if (!read_file_to_slice(alc, filepath, &file_content)) {
-    fprintf(stderr, "Warning: Could not read file '%s'\n", filepath);
-    return false;
-  }
-  str_slice_t rest_of_file;
-  bool needs_write = false;
-  if (slice_starts_with_slice(file_content, golden_header_slice)) {
-    printf("  License OK: %s\n", filepath);
-    return true;
-  }
-  if (slice_starts_with_lit(file_content, "/*")) {
-    printf("  Updating license: %s\n", filepath);
-    needs_write = true;
-    ssize_t end_pos = find_first_block_comment_end(file_content);
-    if (end_pos == -1) {
-      fprintf(stderr,
-              "Warning: Skipping '%s' (malformed block comment at start)\n",
-              filepath);
-      return false;
+/**
+ * @brief 一个待处理的文件; `stamp` 为处理后的 stat 元组 (仅 incremental)
+ */
+typedef struct {
+  const char *path;
+  file_stamp_t stamp;
+  bool ok;
+  bool written;
+  /* (仅 check) 已被检查; --fail-fast 取消后剩下的文件为 false */
+  bool checked;
+  /* (仅 check) 许可证头缺失, 过期或无法识别 */
+  bool dirty;
+} license_file_t;
+
+typedef enum {
+  PREFIX_MATCH,
+  PREFIX_MISMATCH,
+  PREFIX_ERROR,
+} prefix_match_t;
+
+typedef enum {
+  BODY_NO_COMMENT,
+  BODY_AFTER_COMMENT,
+  BODY_MALFORMED,
+  BODY_ERROR,
+} body_kind_t;
+
+/**
+ * @brief 从文件开头读取最多 `len` 字节
+ *
+ * @return 实际读到的字节数, 出错时返回 -1
+ */
+static ssize_t read_prefix(int fd, char *buf, size_t len) {
+  size_t got = 0;
+  while (got < len) {
+    ssize_t n = pread(fd, buf + got, len - got, (off_t)got);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
     }
-    const char *after_comment = file_content.ptr + end_pos + 2;
-    const char *content_start =
-        skip_whitespace(after_comment, file_content.ptr + file_content.len);
-    rest_of_file = (str_slice_t){
-        .ptr = content_start,
-        .len = (size_t)((file_content.ptr + file_content.len) - content_start)};
-  } else {
-    printf("  Adding license: %s\n", filepath);
-    needs_write = true;
-    rest_of_file = file_content;
-  }
-  if (needs_write) {
-    string_t builder;
-    string_init(&builder, alc, golden_header_slice.len + rest_of_file.len + 1);
-    string_append_slice(&builder, golden_header_slice);
-    string_append_slice(&builder, rest_of_file);
-    str_slice_t new_content = string_as_slice(&builder);
-    bool ok = write_file_bytes(filepath, (const void *)new_content.ptr,
-                               new_content.len);
-    string_destroy(&builder);
-    return ok;
+    if (n == 0)
+      break;
+    got += (size_t)n;
   }
-  return true;
+  return (ssize_t)got;
 }
 
-static bool is_excluded(const char *path, vec_t *exclusions) {
-  for (size_t i = 0; i < vec_count(exclusions); i++) {
-    const char *pattern = (const char *)vec_get(exclusions, i);
-    if (strstr(path, pattern) != NULL) {
-      printf("  Excluding: %s (matches '%s')\n", path, pattern);
+/**
+ * @brief 只读取文件开头 `prefix.len` 字节并与 `prefix` 比较
+ *
+ * 绝大多数文件已经带有许可证头, 这样无需把整个文件读入内存。
+ */
+static prefix_match_t file_starts_with(allocer_t *alc, int fd,
+                                       str_slice_t prefix) {
+  char stack_buf[4096];
+  char *buf = stack_buf;
+  if (prefix.len > sizeof(stack_buf)) {
+    buf = allocer_alloc(alc, layout_of_array(char, prefix.len));
+    if (!buf)
+      return PREFIX_ERROR;
+  }
+
+  ssize_t got = read_prefix(fd, buf, prefix.len);
+  if (got < 0)
+    return PREFIX_ERROR;
+  if ((size_t)got == prefix.len && memcmp(buf, prefix.ptr, prefix.len) == 0)
+    return PREFIX_MATCH;
+  return PREFIX_MISMATCH;
+}
+
+/**
+ * @brief 在文件开头 `head` 中找到旧许可证注释之后正文开始的偏移
+ *
+ * @param whole_file `head` 是否已是整个文件
+ * @return false 需要读取更多内容才能判断
+ */
+static bool classify_head(str_slice_t head, bool whole_file, body_kind_t *kind,
+                          size_t *body_offset) {
+  lexer_t lx;
+  lexer_init(&lx, scan_select(), head);
+  lex_token_t tok;
+  if (!lexer_next(&lx, &tok) || tok.kind != LEX_BLOCK_COMMENT) {
+    *body_offset = 0;
+    *kind = BODY_NO_COMMENT;
+    return true;
+  }
+
+  if (tok.terminated) {
+    const char *after_comment = tok.text.ptr + tok.text.len;
+    const char *content_start =
+        skip_whitespace(after_comment, head.ptr + head.len);
+    if (content_start < head.ptr + head.len || whole_file) {
+      *body_offset = (size_t)(content_start - head.ptr);
+      *kind = BODY_AFTER_COMMENT;
       return true;
     }
+  } else if (whole_file) {
+    *kind = BODY_MALFORMED;
+    return true;
   }
   return false;
 }
 
 /**
- * @brief (辅助) 递归遍历目录
+ * @brief 找到旧许可证注释之后正文开始的偏移
+ *
+ * 只读取文件开头足够覆盖第一个块注释的部分 (窗口按需倍增),
+ * 不把整个文件读入内存。
  */
-static void traverse_dir_for_license(allocer_t *alc, const char *current_path,
-                                     vec_t *exclusions,
-                                     str_slice_t golden_header_slice,
-                                     string_t *path_builder) {
-  DIR *dir = opendir(current_path);
-  if (!dir) {
-    fprintf(stderr, "Warning: Could not open directory '%s'\n", current_path);
-    return;
+static body_kind_t locate_body(allocer_t *alc, int fd, size_t file_size,
+                               size_t *body_offset) {
+  size_t window = 4096;
+  for (;;) {
+    if (window > file_size)
+      window = file_size;
+
+    char *buf = allocer_alloc(alc, layout_of_array(char, window + 1));
+    if (!buf)
+      return BODY_ERROR;
+    ssize_t got = read_prefix(fd, buf, window);
+    if (got < 0)
+      return BODY_ERROR;
+    str_slice_t head = {.ptr = buf, .len = (size_t)got};
+    bool whole_file = (size_t)got >= file_size || (size_t)got < window;
+
+    body_kind_t kind;
+    if (classify_head(head, whole_file, &kind, body_offset))
+      return kind;
+    window *= 2;
   }
+}
 
-  struct dirent *dp;
-  while ((dp = readdir(dir)) != NULL) {
-    const char *name = dp->d_name;
-    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
-      continue;
+/**
+ * @brief 用 "新许可证头 + 原文件 [body_offset, EOF)" 原子地替换文件
+ *
+ * 正文通过 copy_file_range 在内核中复制, 不经过用户态缓冲。
+ */
+static bool write_with_header(allocer_t *alc, const char *filepath, int src_fd,
+                              str_slice_t header, size_t body_offset,
+                              size_t file_size) {
+  atomic_file_t af;
+  if (!atomic_file_open(&af, alc, filepath)) {
+    atomic_file_abort(&af);
+    return false;
+  }
+  if (!atomic_file_write(&af, header.ptr, header.len) ||
+      !atomic_file_copy_range(&af, src_fd, (off_t)body_offset,
+                              file_size - body_offset)) {
+    atomic_file_abort(&af);
+    return false;
+  }
+  return atomic_file_commit(&af);
+}
 
-    string_clear(path_builder);
-    string_append_cstr(path_builder, current_path);
-    if (current_path[strlen(current_path) - 1] != '/') {
-      string_push(path_builder, '/');
-    }
-    string_append_cstr(path_builder, name);
+/**
+ * @brief (仅 check) 报告一个不合格的文件, 不做任何写入
+ */
+static bool check_license_of_file(license_file_t *file, body_kind_t kind,
+                                  report_t *rep) {
+  static const char *const reasons[] = {
+      [BODY_NO_COMMENT] = "Missing license",
+      [BODY_AFTER_COMMENT] = "Outdated license",
+      [BODY_MALFORMED] = "Malformed header",
+  };
+  if (kind == BODY_ERROR) {
+    report_err(rep, "Warning: Could not read file '%s'\n", file->path);
+    return false;
+  }
+  file->dirty = true;
+  report_out(rep, "  %s: %s\n", reasons[kind], file->path);
+  return true;
+}
 
-    const char *full_path = string_as_cstr(path_builder);
+static bool apply_license_to_file(allocer_t *alc, license_file_t *file,
+                                  str_slice_t golden_header_slice, bool check,
+                                  report_t *rep) {
+  const char *filepath = file->path;
+
+  int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    report_err(rep, "Warning: Could not read file '%s'\n", filepath);
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
 
-    if (is_excluded(full_path, exclusions)) {
-      continue;
-    }
+  prefix_match_t match = file_starts_with(alc, fd, golden_header_slice);
+  if (match == PREFIX_MATCH) {
+    if (!check)
+      report_out(rep, "  License OK: %s\n", filepath);
+    file_stamp_from_stat(&st, &file->stamp);
+    close(fd);
+    return true;
+  }
 
-    struct stat statbuf;
-    if (stat(full_path, &statbuf) != 0) {
-      fprintf(stderr, "Warning: Could not stat file '%s'\n", full_path);
-      continue;
-    }
+  size_t file_size = (size_t)st.st_size;
+  size_t body_offset = 0;
+  body_kind_t kind = match == PREFIX_ERROR
+                         ? BODY_ERROR
+                         : locate_body(alc, fd, file_size, &body_offset);
 
-    if (S_ISDIR(statbuf.st_mode)) {
+  if (check) {
+    close(fd);
+    return check_license_of_file(file, kind, rep);
+  }
 
-      char *stable_path = allocer_strdup(alc, full_path);
-      if (stable_path) {
-        traverse_dir_for_license(alc, stable_path, exclusions,
-                                 golden_header_slice, path_builder);
+  switch (kind) {
+  case BODY_ERROR:
+    report_err(rep, "Warning: Could not read file '%s'\n", filepath);
+    close(fd);
+    return false;
+  case BODY_MALFORMED:
+    report_out(rep, "  Updating license: %s\n", filepath);
+    report_err(rep,
+               "Warning: Skipping '%s' (malformed block comment at start)\n",
+               filepath);
+    close(fd);
+    return false;
+  case BODY_AFTER_COMMENT:
+    report_out(rep, "  Updating license: %s\n", filepath);
+    break;
+  case BODY_NO_COMMENT:
+    report_out(rep, "  Adding license: %s\n", filepath);
+    break;
+  }
+
+  bool ok = write_with_header(alc, filepath, fd, golden_header_slice,
+                              body_offset, file_size);
+  close(fd);
+  if (!ok) {
+    report_err(rep, "Error: Failed to write file '%s'.\n", filepath);
+    return false;
+  }
+  file->written = true;
+  return true;
+}
+
+static bool license_job(void *ctx, job_worker_t *worker, void *job,
+                        report_t *rep) {
+  license_ctx_t *license_ctx = ctx;
+  const license_opts_t *opts = license_ctx->opts;
+  license_file_t *file = job;
+  file->checked = true;
+  file->ok = apply_license_to_file(&worker->scratch, file,
+                                   license_ctx->golden_header, opts->check,
+                                   rep);
+  if (opts->fail_fast && (!file->ok || file->dirty))
+    job_pool_cancel(worker->pool);
+  return file->ok;
+}
+
+typedef struct {
+  allocer_t *alc;
+  const exclude_set_t *exclude;
+  bool verbose;
+  unsigned walk_flags;
+  job_pool_t *pool;
+  vec_t *files;
+  /* 仅 incremental: 清单与当前许可证头的哈希 */
+  const cache_t *cache;
+  uint64_t license_hash;
+  size_t skipped;
+} license_walk_t;
+
+/**
+ * @brief 判断路径是否被排除; 只有 verbose 时才打印命中的模式
+ */
+static bool is_excluded(license_walk_t *walk, const char *path, bool is_dir) {
+  const char *pattern =
+      exclude_match(walk->exclude, slice_from_cstr(path), is_dir);
+  if (pattern && walk->verbose) {
+    job_pool_note(walk->pool, stdout, "  Excluding: %s (matches '%s')\n",
+                  path, pattern);
+  }
+  return pattern != NULL;
+}
+
+/**
+ * @brief 提交一个文件; incremental 模式下 stat 元组未变的文件直接跳过
+ */
+static void submit_license_file(license_walk_t *walk, const char *path) {
+  if (walk->cache) {
+    struct stat st;
+    const cache_entry_t *entry = cache_lookup(walk->cache, path);
+    if (entry && entry->license_hash == walk->license_hash &&
+        stat(path, &st) == 0) {
+      file_stamp_t stamp;
+      file_stamp_from_stat(&st, &stamp);
+      if (file_stamp_equals(&entry->stamp, &stamp)) {
+        walk->skipped++;
+        return;
       }
-    } else if (is_licensable_file(full_path)) {
-      apply_license_to_file(alc, full_path, golden_header_slice);
     }
   }
-  closedir(dir);
+
+  license_file_t *file = allocer_alloc(walk->alc, layout_of(license_file_t));
+  if (!file)
+    return;
+  memset(file, 0, sizeof(*file));
+  file->path = path;
+  if (vec_push(walk->files, file))
+    job_pool_submit(walk->pool, file);
 }
 
 /**
- * @brief 'license' 命令的入口函数
+ * @brief (辅助) 遍历回调: 过滤排除项, 提交可加许可证的文件
  */
-bool cnote_license_run(allocer_t *alc, vec_t *targets, vec_t *exclusions,
-                       const char *license_file) {
+static bool license_visit(void *ctx, const walk_entry_t *entry) {
+  license_walk_t *walk = ctx;
+  const char *full_path = entry->path.ptr;
 
-  string_t golden_header;
-  if (!string_init(&golden_header, alc, 1024))
+  if (job_pool_cancelled(walk->pool))
+    return false;
+
+  switch (entry->kind) {
+  case WALK_ERR_OPEN_DIR:
+    job_pool_note(walk->pool, stderr,
+                  "Warning: Could not open directory '%s'\n", full_path);
+    return false;
+  case WALK_ERR_STAT:
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat file '%s'\n",
+                  full_path);
+    return false;
+  default:
+    break;
+  }
+
+  if (is_excluded(walk, full_path, entry->kind == WALK_DIR)) {
+    return false;
+  }
+
+  if (entry->kind == WALK_FILE && is_licensable_file(full_path)) {
+    char *stable_path = allocer_strdup(walk->alc, full_path);
+    if (stable_path) {
+      submit_license_file(walk, stable_path);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 处理一个路径: 目录则遍历 (仅当 `walk_dirs`), 普通文件则直接提交
+ *
+ * @param path 须在整个运行期间有效
+ * @return false 表示已被 --fail-fast 取消, 不必再处理后续目标
+ */
+static bool license_path(license_walk_t *walk, const char *path,
+                    bool walk_dirs) {
+  if (job_pool_cancelled(walk->pool))
+    return false;
+
+  struct stat statbuf;
+  if (stat(path, &statbuf) != 0) {
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat target '%s'\n",
+                  path);
+    return true;
+  }
+
+  if (is_excluded(walk, path, S_ISDIR(statbuf.st_mode))) {
+    return true;
+  }
+
+  if (S_ISDIR(statbuf.st_mode)) {
+    if (walk_dirs)
+      walk_tree(walk->alc, path, walk->walk_flags, license_visit, walk);
+  } else if (S_ISREG(statbuf.st_mode) && is_licensable_file(path)) {
+    submit_license_file(walk, path);
+  }
+  return !job_pool_cancelled(walk->pool);
+}
+
+/**
+ * @brief 处理命令行上的一个目标: 目录则遍历, 文件则直接提交
+ */
+static bool license_target(void *ctx, const char *path) {
+  return license_path(ctx, path, true);
+}
+
+/**
+ * @brief --files-from / --changed-since 回调: 只接受普通文件
+ *
+ * 列表中的目录 (例如 git 列出的子模块) 不展开, 以免处理整个第三方代码树。
+ */
+static bool license_listed_path(void *ctx, const char *path) {
+  license_walk_t *walk = ctx;
+  char *stable_path = allocer_strdup(walk->alc, path);
+  if (!stable_path)
+    return false;
+  return license_path(walk, stable_path, false);
+}
+
+/**
+ * @brief (仅 check) 打印检查结果
+ *
+ * @return true 所有文件都带有当前的许可证头, 且都能读取
+ */
+static bool report_license_check(vec_t *files, size_t skipped, bool stopped) {
+  size_t n_checked = skipped, n_dirty = 0, n_failed = 0;
+  for (size_t i = 0; i < vec_count(files); i++) {
+    license_file_t *file = vec_get(files, i);
+    if (!file->checked)
+      continue;
+    n_checked++;
+    if (!file->ok)
+      n_failed++;
+    else if (file->dirty)
+      n_dirty++;
+  }
+  printf("  %zu of %zu file(s) need a license update", n_dirty, n_checked);
+  if (n_failed > 0)
+    printf(", %zu failed", n_failed);
+  if (stopped)
+    printf(" (stopped at the first failure)");
+  printf(".\n");
+  return n_dirty == 0 && n_failed == 0;
+}
+
+bool license_header_load(allocer_t *alc, const char *license_file,
+                         string_t *golden_header) {
+  if (!string_init(golden_header, alc, 1024))
     return false;
 
   str_slice_t raw_license;
   if (!read_file_to_slice(alc, license_file, &raw_license)) {
     fprintf(stderr, "Error: Failed to read license file '%s'\n", license_file);
+    string_destroy(golden_header);
+    return false;
+  }
+
+  format_license_as_comment(alc, raw_license, golden_header);
+  return true;
+}
+
+license_status_t license_check_buffer(str_slice_t header, str_slice_t content,
+                                      size_t *body_offset) {
+  *body_offset = 0;
+  if (content.len >= header.len &&
+      memcmp(content.ptr, header.ptr, header.len) == 0)
+    return LICENSE_PRESENT;
+
+  body_kind_t kind;
+  classify_head(content, true, &kind, body_offset);
+  switch (kind) {
+  case BODY_NO_COMMENT:
+    return LICENSE_MISSING;
+  case BODY_AFTER_COMMENT:
+    return LICENSE_OUTDATED;
+  default:
+    return LICENSE_MALFORMED;
+  }
+}
+
+bool cnote_license_stdin(allocer_t *alc, const license_opts_t *opts) {
+  string_t golden_header;
+  if (!license_header_load(alc, opts->license_file, &golden_header))
+    return false;
+  str_slice_t golden_slice = string_as_slice(&golden_header);
+
+  str_slice_t content;
+  if (!stdio_filter_read(alc, &content)) {
     string_destroy(&golden_header);
     return false;
   }
 
-  format_license_as_comment(alc, raw_license, &golden_header);
+  bool ok = false;
+  size_t body_offset = 0;
+  switch (license_check_buffer(golden_slice, content, &body_offset)) {
+  case LICENSE_PRESENT:
+    ok = stdio_filter_write(content);
+    break;
+  case LICENSE_MALFORMED:
+    fprintf(stderr, "Error: Malformed block comment at start of stdin\n");
+    break;
+  case LICENSE_MISSING:
+  case LICENSE_OUTDATED: {
+    str_slice_t body = {.ptr = content.ptr + body_offset,
+                        .len = content.len - body_offset};
+    ok = stdio_filter_write(golden_slice) && stdio_filter_write(body);
+    break;
+  }
+  }
+
+  string_destroy(&golden_header);
+  return ok;
+}
+
+/**
+ * @brief 'license' 命令的入口函数
+ */
+bool cnote_license_run(allocer_t *alc, vec_t *targets, vec_t *exclusions,
+                       const license_opts_t *opts) {
+  string_t golden_header;
+  if (!license_header_load(alc, opts->license_file, &golden_header))
+    return false;
   str_slice_t golden_slice = string_as_slice(&golden_header);
 
-  string_t path_builder;
-  if (!string_init(&path_builder, alc, 256)) {
+  cache_t cache;
+  if (opts->incremental && !cache_load(&cache, alc, CACHE_DEFAULT_FILE)) {
     string_destroy(&golden_header);
     return false;
   }
 
-  for (size_t i = 0; i < vec_count(targets); i++) {
-    const char *target_path = (const char *)vec_get(targets, i);
+  vec_t files;
+  if (!vec_init(&files, alc, 0)) {
+    string_destroy(&golden_header);
+    return false;
+  }
 
-    if (is_excluded(target_path, exclusions)) {
-      continue;
-    }
+  exclude_set_t exclude;
+  if (!exclude_set_init(&exclude, alc, exclusions)) {
+    string_destroy(&golden_header);
+    return false;
+  }
 
-    struct stat statbuf;
-    if (stat(target_path, &statbuf) != 0) {
-      fprintf(stderr, "Warning: Could not stat target '%s'\n", target_path);
-      continue;
+  license_ctx_t ctx = {.golden_header = golden_slice, .opts = opts};
+  job_pool_t pool;
+  if (!job_pool_init(&pool, alc, opts->jobs, license_job, &ctx)) {
+    string_destroy(&golden_header);
+    return false;
+  }
+
+  license_walk_t walk = {
+      .alc = alc,
+      .exclude = &exclude,
+      .verbose = opts->verbose,
+      .walk_flags = opts->no_ignore ? WALK_NO_FLAGS : WALK_HONOR_IGNORE,
+      .pool = &pool,
+      .files = &files,
+      .cache = opts->incremental ? &cache : NULL,
+      .license_hash = cache_hash(golden_slice.ptr, golden_slice.len),
+      .skipped = 0,
+  };
+
+  bool list_ok = true;
+  if (opts->changed_since) {
+    list_ok = git_changed_files(alc, opts->changed_since, NULL, targets,
+                                license_listed_path, &walk);
+  } else {
+    for (size_t i = 0; i < vec_count(targets); i++) {
+      if (!license_target(&walk, (const char *)vec_get(targets, i)))
+        break;
     }
+  }
+  if (opts->files_from &&
+      !path_list_read(alc, opts->files_from, license_listed_path, &walk)) {
+    list_ok = false;
+  }
 
-    if (S_ISDIR(statbuf.st_mode)) {
+  job_pool_wait(&pool);
+  bool stopped = job_pool_cancelled(&pool);
+  job_pool_destroy(&pool);
 
-      char *stable_path = allocer_strdup(alc, target_path);
-      if (stable_path) {
-        traverse_dir_for_license(alc, stable_path, exclusions, golden_slice,
-                                 &path_builder);
-      }
-    } else {
-      if (is_licensable_file(target_path)) {
-        apply_license_to_file(alc, target_path, golden_slice);
+  if (opts->check) {
+    bool check_ok = report_license_check(&files, walk.skipped, stopped);
+    vec_destroy(&files);
+    string_destroy(&golden_header);
+    /* 被取消时路径列表的读取会提前结束, 那不算额外的错误 */
+    return check_ok && (list_ok || stopped);
+  }
+
+  if (opts->incremental) {
+    for (size_t i = 0; i < vec_count(&files); i++) {
+      license_file_t *file = vec_get(&files, i);
+      struct stat st;
+      if (file->ok && file->written && stat(file->path, &st) == 0) {
+        file_stamp_from_stat(&st, &file->stamp);
+      } else if (!file->ok || file->written) {
+        cache_forget(&cache, file->path);
+        continue;
       }
+      cache_update(&cache, file->path, &file->stamp, 0, 0, walk.license_hash,
+                   0);
+    }
+    printf("  Skipped %zu unchanged file(s) (incremental).\n", walk.skipped);
+    if (!cache_save(&cache)) {
+      fprintf(stderr, "Warning: Could not write cache file '%s'\n",
+              CACHE_DEFAULT_FILE);
     }
   }
 
-  string_destroy(&path_builder);
+  vec_destroy(&files);
   string_destroy(&golden_header);
-  return true;
+  return list_ok;
 }
\ No newline at end of file
@@ -28,8 +28,12 @@
 #include <clean.h>
 #include <doc.h>
 #include <license.h>
+#include <pipeline.h>
+#include <pool.h>
 
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /**
@@ -39,26 +43,130 @@ static void print_usage(void) {
   fprintf(stderr, "Usage: cnote <command> [options] [targets...]\n");
   fprintf(stderr, "\nCommands:\n");
   fprintf(stderr, "  clean [opts] <paths...>    Removes '//' comments and runs "
-                  "clang-format.\n");
+                  "clang-format ('-' = stdin).\n");
 
-  fprintf(stderr, "  doc <src_dir> <out_dir>     Generates markdown "
+  fprintf(stderr, "  doc [opts] <src_dir> <out_dir>  Generates markdown "
                   "documentation (mdBook compatible).\n");
-  fprintf(
-      stderr,
-      "  license [opts] <paths...>   Applies or maintains a license header.\n");
+  fprintf(stderr, "  license [opts] <paths...>   Applies or maintains a "
+                  "license header ('-' = stdin).\n");
+  fprintf(stderr, "  all [opts] <src_dir> [out_dir]  Runs license, clean and "
+                  "doc in a single pass.\n");
 
   fprintf(stderr, "\nGeneral Options:\n");
   fprintf(stderr, "  -h, --help                 Show this help message.\n");
+  fprintf(stderr, "  -j, --jobs <N>             Number of worker threads "
+                  "(default: online CPUs).\n");
+  fprintf(stderr, "      --no-ignore            Do not skip paths listed in "
+                  ".gitignore / .ignore files.\n");
+  fprintf(stderr, "      --changed-since <rev>  Only process files changed "
+                  "or untracked relative to git <rev>.\n");
 
   fprintf(stderr, "\n'clean' Options:\n");
-  fprintf(stderr, "  -e, --exclude <path>       Exclude a file/directory.\n");
+  fprintf(stderr, "  -e, --exclude <pattern>    Exclude paths containing "
+                  "<pattern>; '^dir/' anchors, '*?[' globs.\n");
+  fprintf(stderr, "  -v, --verbose              Print each excluded path.\n");
   fprintf(stderr,
           "  -s, --style <file>         Path to .clang-format file to use.\n");
+  fprintf(stderr, "      --assume-filename <f>  With '-', the file name passed "
+                  "to clang-format (default: stdin.c).\n");
+  fprintf(stderr, "      --files-from <file>    Also process paths listed in "
+                  "<file> ('-' = stdin), split on the first NUL/newline "
+                  "seen.\n");
+  fprintf(stderr, "  -p, --pipe                 Pipe each file through "
+                  "clang-format; write only if changed.\n");
+  fprintf(stderr, "  -i, --incremental          Skip files unchanged since "
+                  "the last run (.cnote-cache).\n");
+  fprintf(stderr, "      --check                List files that still need "
+                  "cleaning; never writes.\n");
+  fprintf(stderr, "      --fail-fast            With --check, stop at the "
+                  "first failure.\n");
 
   fprintf(stderr, "\n'license' Options:\n");
-  fprintf(stderr, "  -e, --exclude <path>       Exclude a file/directory.\n");
+  fprintf(stderr, "  -e, --exclude <pattern>    Exclude paths containing "
+                  "<pattern>; '^dir/' anchors, '*?[' globs.\n");
+  fprintf(stderr, "  -v, --verbose              Print each excluded path.\n");
+  fprintf(stderr, "      --files-from <file>    Also process paths listed in "
+                  "<file> ('-' = stdin), split on the first NUL/newline "
+                  "seen.\n");
   fprintf(stderr, "  -f, --file <license_file>  (Required) Path to the license "
                   "text file.\n");
+  fprintf(stderr, "  -i, --incremental          Skip files unchanged since "
+                  "the last run (.cnote-cache).\n");
+  fprintf(stderr, "      --check                List files with a missing or "
+                  "outdated header; never writes.\n");
+  fprintf(stderr, "      --fail-fast            With --check, stop at the "
+                  "first failure.\n");
+
+  fprintf(stderr, "\n'doc' Options:\n");
+  fprintf(stderr, "      --search               Also write a prefix-sharded "
+                  "search index (search/).\n");
+  fprintf(stderr, "      --from-index           Re-render <out_dir> from its "
+                  "index without reading sources.\n");
+  fprintf(stderr, "      --split-above <size>   One page per symbol for "
+                  "sources with over <size> bytes of docs (K/M).\n");
+
+  fprintf(stderr, "\n'all' Options:\n");
+  fprintf(stderr, "      --pipeline <steps>     Comma-separated steps to run "
+                  "(default: license,clean,doc).\n");
+  fprintf(stderr, "  -f, --file <license_file>  License text file (required "
+                  "by the license step).\n");
+  fprintf(stderr,
+          "  -s, --style <file>         Path to .clang-format file to use.\n");
+  fprintf(stderr, "      --split-above <size>   As for 'doc'.\n");
+  fprintf(stderr, "  -e, --exclude <pattern>    Exclude paths containing "
+                  "<pattern>; '^dir/' anchors, '*?[' globs.\n");
+  fprintf(stderr, "  -v, --verbose              Print each excluded path.\n");
+}
+
+/**
+ * @brief 解析 -j/--jobs 的参数值 (正整数)
+ */
+static bool parse_jobs(str_slice_t value, size_t *out_jobs) {
+  char *end = NULL;
+  unsigned long n = strtoul(value.ptr, &end, 10);
+  if (value.len == 0 || end != value.ptr + value.len || n == 0) {
+    fprintf(stderr, "Error: Invalid job count '%.*s'\n", (int)value.len,
+            value.ptr);
+    return false;
+  }
+  *out_jobs = (size_t)n;
+  return true;
+}
+
+/**
+ * @brief 解析 --split-above 的参数值: 字节数, 可带后缀 K 或 M (1024 进制)
+ */
+static bool parse_size(str_slice_t value, size_t *out_size) {
+  char *end = NULL;
+  unsigned long long n = strtoull(value.ptr, &end, 10);
+  unsigned long long unit = 1;
+  if (value.len > 0 && end == value.ptr + value.len - 1) {
+    if (*end == 'K' || *end == 'k')
+      unit = 1024;
+    else if (*end == 'M' || *end == 'm')
+      unit = 1024 * 1024;
+    if (unit > 1)
+      end++;
+  }
+  if (value.len == 0 || end != value.ptr + value.len || n == 0 ||
+      n > SIZE_MAX / unit || (value.ptr[0] < '0' || value.ptr[0] > '9')) {
+    fprintf(stderr, "Error: Invalid size '%.*s'\n", (int)value.len,
+            value.ptr);
+    return false;
+  }
+  *out_size = (size_t)(n * unit);
+  return true;
+}
+
+/**
+ * @brief 目标中是否有 `-` (过滤模式: 标准输入到标准输出)
+ */
+static bool is_stdin_filter(vec_t *targets) {
+  for (size_t i = 0; i < vec_count(targets); i++) {
+    if (strcmp((const char *)vec_get(targets, i), "-") == 0)
+      return true;
+  }
+  return false;
 }
 
 /**
@@ -67,7 +175,19 @@ static void print_usage(void) {
 static bool cmd_clean(allocer_t *alc, args_parser_t *p) {
   vec_t targets;
   vec_t exclusions;
-  const char *style_file = NULL;
+  clean_opts_t opts = {
+      .style_file = NULL,
+      .jobs = job_pool_default_workers(),
+      .pipe = false,
+      .incremental = false,
+      .verbose = false,
+      .no_ignore = false,
+      .files_from = NULL,
+      .changed_since = NULL,
+      .check = false,
+      .fail_fast = false,
+      .assume_filename = NULL,
+  };
 
   if (!vec_init(&targets, alc, 0) || !vec_init(&exclusions, alc, 0))
     return false;
@@ -78,7 +198,12 @@ static bool cmd_clean(allocer_t *alc, args_parser_t *p) {
   while ((type = args_parser_peek(p, &arg)) != ARG_TYPE_END) {
     if (type == ARG_TYPE_FLAG) {
       args_parser_consume(p, &arg);
-      if (slice_equals_cstr(arg, "-e") || slice_equals_cstr(arg, "--exclude")) {
+      if (slice_equals_cstr(arg, "-")) {
+        /* 单独的 `-` 是目标 (标准输入), 不是选项 */
+        if (!vec_push(&targets, (void *)arg.ptr))
+          return false;
+      } else if (slice_equals_cstr(arg, "-e") ||
+                 slice_equals_cstr(arg, "--exclude")) {
         if (!args_parser_consume_value(p, arg.ptr, &value))
           return false;
         if (!vec_push(&exclusions, (void *)value.ptr))
@@ -87,7 +212,40 @@ static bool cmd_clean(allocer_t *alc, args_parser_t *p) {
                  slice_equals_cstr(arg, "--style")) {
         if (!args_parser_consume_value(p, arg.ptr, &value))
           return false;
-        style_file = value.ptr;
+        opts.style_file = value.ptr;
+      } else if (slice_equals_cstr(arg, "--assume-filename")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.assume_filename = value.ptr;
+      } else if (slice_equals_cstr(arg, "-j") ||
+                 slice_equals_cstr(arg, "--jobs")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_jobs(value, &opts.jobs))
+          return false;
+      } else if (slice_equals_cstr(arg, "-p") ||
+                 slice_equals_cstr(arg, "--pipe")) {
+        opts.pipe = true;
+      } else if (slice_equals_cstr(arg, "-i") ||
+                 slice_equals_cstr(arg, "--incremental")) {
+        opts.incremental = true;
+      } else if (slice_equals_cstr(arg, "-v") ||
+                 slice_equals_cstr(arg, "--verbose")) {
+        opts.verbose = true;
+      } else if (slice_equals_cstr(arg, "--no-ignore")) {
+        opts.no_ignore = true;
+      } else if (slice_equals_cstr(arg, "--check")) {
+        opts.check = true;
+      } else if (slice_equals_cstr(arg, "--fail-fast")) {
+        opts.fail_fast = true;
+      } else if (slice_equals_cstr(arg, "--changed-since")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.changed_since = value.ptr;
+      } else if (slice_equals_cstr(arg, "--files-from")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.files_from = value.ptr;
       } else {
         fprintf(stderr, "Error: Unknown flag '%.*s' for 'clean' command\n",
                 (int)arg.len, arg.ptr);
@@ -100,13 +258,32 @@ static bool cmd_clean(allocer_t *alc, args_parser_t *p) {
     }
   }
 
-  if (vec_count(&targets) == 0) {
+  if (vec_count(&targets) == 0 && opts.files_from == NULL &&
+      opts.changed_since == NULL) {
     fprintf(stderr,
-            "Error: 'clean' command requires at least one target path.\n");
+            "Error: 'clean' command requires a target path, --files-from "
+            "or --changed-since.\n");
+    return false;
+  }
+  if (opts.fail_fast && !opts.check) {
+    fprintf(stderr, "Error: --fail-fast requires --check.\n");
     return false;
   }
 
-  bool ok = cnote_clean_run(alc, &targets, &exclusions, style_file);
+  /* 过滤模式: 标准输出只能是处理结果, 不打印标题 */
+  if (is_stdin_filter(&targets)) {
+    if (vec_count(&targets) != 1 || opts.files_from || opts.changed_since ||
+        opts.check) {
+      fprintf(stderr, "Error: '-' (stdin) cannot be combined with other "
+                      "targets, --files-from, --changed-since or --check.\n");
+      return false;
+    }
+    return cnote_clean_stdin(alc, &opts);
+  }
+
+  printf("--- cnote: Cleaning ---\n");
+  bool ok = cnote_clean_run(alc, &targets, &exclusions, &opts);
+  printf("-------------------------\n");
   vec_destroy(&exclusions);
   vec_destroy(&targets);
   return ok;
@@ -116,28 +293,84 @@ static bool cmd_clean(allocer_t *alc, args_parser_t *p) {
  * @brief 'doc' 命令的实现
  */
 static bool cmd_doc(allocer_t *alc, args_parser_t *p) {
+  const char *dirs[2] = {NULL, NULL};
+  size_t n_dirs = 0;
+  doc_opts_t opts = {
+      .jobs = job_pool_default_workers(),
+      .no_ignore = false,
+      .changed_since = NULL,
+      .search = false,
+      .split_above = 0,
+  };
+  bool from_index = false;
 
-  str_slice_t src_dir_slice, out_dir_slice;
+  str_slice_t arg, value;
+  arg_type_t type;
 
-  arg_type_t type = args_parser_consume(p, &src_dir_slice);
-  if (type != ARG_TYPE_POSITIONAL) {
-    fprintf(stderr, "Error: 'doc' command expected <src_dir> argument.\n");
-    return false;
+  while ((type = args_parser_peek(p, &arg)) != ARG_TYPE_END) {
+    if (type == ARG_TYPE_FLAG) {
+      args_parser_consume(p, &arg);
+      if (slice_equals_cstr(arg, "-j") || slice_equals_cstr(arg, "--jobs")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_jobs(value, &opts.jobs))
+          return false;
+      } else if (slice_equals_cstr(arg, "--no-ignore")) {
+        opts.no_ignore = true;
+      } else if (slice_equals_cstr(arg, "--search")) {
+        opts.search = true;
+      } else if (slice_equals_cstr(arg, "--from-index")) {
+        from_index = true;
+      } else if (slice_equals_cstr(arg, "--split-above")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_size(value, &opts.split_above))
+          return false;
+      } else if (slice_equals_cstr(arg, "--changed-since")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.changed_since = value.ptr;
+      } else {
+        fprintf(stderr, "Error: Unknown flag '%.*s' for 'doc' command\n",
+                (int)arg.len, arg.ptr);
+        return false;
+      }
+    } else if (type == ARG_TYPE_POSITIONAL) {
+      args_parser_consume(p, &arg);
+      if (n_dirs == 2) {
+        fprintf(stderr, "Error: 'doc' command got too many arguments. "
+                        "Expected only 2.\n");
+        return false;
+      }
+      dirs[n_dirs++] = arg.ptr;
+    }
   }
 
-  type = args_parser_consume(p, &out_dir_slice);
-  if (type != ARG_TYPE_POSITIONAL) {
-    fprintf(stderr, "Error: 'doc' command expected <out_dir> argument.\n");
+  if (from_index) {
+    /* 只需要输出目录, 不读取任何源文件 */
+    if (n_dirs != 1) {
+      fprintf(stderr,
+              "Error: 'doc --from-index' expected only <out_dir> argument.\n");
+      return false;
+    }
+    printf("--- cnote: Generating Docs ---\n");
+    bool ok = cnote_doc_render_index(alc, dirs[0], &opts);
+    printf("------------------------------\n");
+    return ok;
+  }
+  if (n_dirs == 0) {
+    fprintf(stderr, "Error: 'doc' command expected <src_dir> argument.\n");
     return false;
   }
-  str_slice_t dummy;
-  if (args_parser_peek(p, &dummy) == ARG_TYPE_POSITIONAL) {
-    fprintf(stderr,
-            "Error: 'doc' command got too many arguments. Expected only 2.\n");
+  if (n_dirs == 1) {
+    fprintf(stderr, "Error: 'doc' command expected <out_dir> argument.\n");
     return false;
   }
 
-  return cnote_doc_run(alc, src_dir_slice.ptr, out_dir_slice.ptr);
+  printf("--- cnote: Generating Docs ---\n");
+  bool ok = cnote_doc_run(alc, dirs[0], dirs[1], &opts);
+  printf("------------------------------\n");
+  return ok;
 }
 
 /**
@@ -146,7 +379,17 @@ static bool cmd_doc(allocer_t *alc, args_parser_t *p) {
 static bool cmd_license(allocer_t *alc, args_parser_t *p) {
   vec_t targets;
   vec_t exclusions;
-  const char *license_file = NULL;
+  license_opts_t opts = {
+      .license_file = NULL,
+      .jobs = job_pool_default_workers(),
+      .incremental = false,
+      .verbose = false,
+      .no_ignore = false,
+      .files_from = NULL,
+      .changed_since = NULL,
+      .check = false,
+      .fail_fast = false,
+  };
 
   if (!vec_init(&targets, alc, 0) || !vec_init(&exclusions, alc, 0))
     return false;
@@ -157,7 +400,12 @@ static bool cmd_license(allocer_t *alc, args_parser_t *p) {
   while ((type = args_parser_peek(p, &arg)) != ARG_TYPE_END) {
     if (type == ARG_TYPE_FLAG) {
       args_parser_consume(p, &arg);
-      if (slice_equals_cstr(arg, "-e") || slice_equals_cstr(arg, "--exclude")) {
+      if (slice_equals_cstr(arg, "-")) {
+        /* 单独的 `-` 是目标 (标准输入), 不是选项 */
+        if (!vec_push(&targets, (void *)arg.ptr))
+          return false;
+      } else if (slice_equals_cstr(arg, "-e") ||
+                 slice_equals_cstr(arg, "--exclude")) {
         if (!args_parser_consume_value(p, arg.ptr, &value))
           return false;
         if (!vec_push(&exclusions, (void *)value.ptr))
@@ -166,7 +414,33 @@ static bool cmd_license(allocer_t *alc, args_parser_t *p) {
                  slice_equals_cstr(arg, "--file")) {
         if (!args_parser_consume_value(p, arg.ptr, &value))
           return false;
-        license_file = value.ptr;
+        opts.license_file = value.ptr;
+      } else if (slice_equals_cstr(arg, "-j") ||
+                 slice_equals_cstr(arg, "--jobs")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_jobs(value, &opts.jobs))
+          return false;
+      } else if (slice_equals_cstr(arg, "-i") ||
+                 slice_equals_cstr(arg, "--incremental")) {
+        opts.incremental = true;
+      } else if (slice_equals_cstr(arg, "-v") ||
+                 slice_equals_cstr(arg, "--verbose")) {
+        opts.verbose = true;
+      } else if (slice_equals_cstr(arg, "--no-ignore")) {
+        opts.no_ignore = true;
+      } else if (slice_equals_cstr(arg, "--check")) {
+        opts.check = true;
+      } else if (slice_equals_cstr(arg, "--fail-fast")) {
+        opts.fail_fast = true;
+      } else if (slice_equals_cstr(arg, "--changed-since")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.changed_since = value.ptr;
+      } else if (slice_equals_cstr(arg, "--files-from")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.files_from = value.ptr;
       } else {
         fprintf(stderr, "Error: Unknown flag '%.*s' for 'license' command\n",
                 (int)arg.len, arg.ptr);
@@ -179,23 +453,142 @@ static bool cmd_license(allocer_t *alc, args_parser_t *p) {
     }
   }
 
-  if (license_file == NULL) {
+  if (opts.license_file == NULL) {
     fprintf(stderr, "Error: 'license' command requires a --file <license_file> "
                     "argument.\n");
     return false;
   }
-  if (vec_count(&targets) == 0) {
+  if (vec_count(&targets) == 0 && opts.files_from == NULL &&
+      opts.changed_since == NULL) {
     fprintf(stderr,
-            "Error: 'license' command requires at least one target path.\n");
+            "Error: 'license' command requires a target path, --files-from "
+            "or --changed-since.\n");
+    return false;
+  }
+  if (opts.fail_fast && !opts.check) {
+    fprintf(stderr, "Error: --fail-fast requires --check.\n");
     return false;
   }
 
-  bool ok = cnote_license_run(alc, &targets, &exclusions, license_file);
+  /* 过滤模式: 标准输出只能是处理结果, 不打印标题 */
+  if (is_stdin_filter(&targets)) {
+    if (vec_count(&targets) != 1 || opts.files_from || opts.changed_since ||
+        opts.check) {
+      fprintf(stderr, "Error: '-' (stdin) cannot be combined with other "
+                      "targets, --files-from, --changed-since or --check.\n");
+      return false;
+    }
+    return cnote_license_stdin(alc, &opts);
+  }
+
+  printf("--- cnote: Applying License ---\n");
+  bool ok = cnote_license_run(alc, &targets, &exclusions, &opts);
+  printf("-------------------------------\n");
   vec_destroy(&exclusions);
   vec_destroy(&targets);
   return ok;
 }
 
+/**
+ * @brief 'all' 命令的实现
+ */
+static bool cmd_all(allocer_t *alc, args_parser_t *p) {
+  const char *dirs[2] = {NULL, NULL};
+  size_t n_dirs = 0;
+  vec_t exclusions;
+  pipeline_opts_t opts = {
+      .steps = PIPELINE_ALL,
+      .license_file = NULL,
+      .style_file = NULL,
+      .jobs = job_pool_default_workers(),
+      .verbose = false,
+      .no_ignore = false,
+      .split_above = 0,
+  };
+
+  if (!vec_init(&exclusions, alc, 0))
+    return false;
+
+  str_slice_t arg, value;
+  arg_type_t type;
+
+  while ((type = args_parser_peek(p, &arg)) != ARG_TYPE_END) {
+    if (type == ARG_TYPE_FLAG) {
+      args_parser_consume(p, &arg);
+      if (slice_equals_cstr(arg, "--pipeline")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!pipeline_parse_steps(value.ptr, &opts.steps))
+          return false;
+      } else if (slice_equals_cstr(arg, "-f") ||
+                 slice_equals_cstr(arg, "--file")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.license_file = value.ptr;
+      } else if (slice_equals_cstr(arg, "-s") ||
+                 slice_equals_cstr(arg, "--style")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        opts.style_file = value.ptr;
+      } else if (slice_equals_cstr(arg, "-e") ||
+                 slice_equals_cstr(arg, "--exclude")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!vec_push(&exclusions, (void *)value.ptr))
+          return false;
+      } else if (slice_equals_cstr(arg, "-j") ||
+                 slice_equals_cstr(arg, "--jobs")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_jobs(value, &opts.jobs))
+          return false;
+      } else if (slice_equals_cstr(arg, "-v") ||
+                 slice_equals_cstr(arg, "--verbose")) {
+        opts.verbose = true;
+      } else if (slice_equals_cstr(arg, "--no-ignore")) {
+        opts.no_ignore = true;
+      } else if (slice_equals_cstr(arg, "--split-above")) {
+        if (!args_parser_consume_value(p, arg.ptr, &value))
+          return false;
+        if (!parse_size(value, &opts.split_above))
+          return false;
+      } else {
+        fprintf(stderr, "Error: Unknown flag '%.*s' for 'all' command\n",
+                (int)arg.len, arg.ptr);
+        return false;
+      }
+    } else if (type == ARG_TYPE_POSITIONAL) {
+      args_parser_consume(p, &arg);
+      if (n_dirs == 2) {
+        fprintf(stderr, "Error: 'all' command got too many arguments. "
+                        "Expected at most 2.\n");
+        return false;
+      }
+      dirs[n_dirs++] = arg.ptr;
+    }
+  }
+
+  if (n_dirs == 0) {
+    fprintf(stderr, "Error: 'all' command expected <src_dir> argument.\n");
+    return false;
+  }
+  if ((opts.steps & PIPELINE_DOC) && n_dirs == 1) {
+    fprintf(stderr, "Error: The doc step expects an <out_dir> argument.\n");
+    return false;
+  }
+  if ((opts.steps & PIPELINE_LICENSE) && opts.license_file == NULL) {
+    fprintf(stderr, "Error: The license step requires a --file "
+                    "<license_file> argument.\n");
+    return false;
+  }
+
+  printf("--- cnote: Running Pipeline ---\n");
+  bool ok = cnote_pipeline_run(alc, dirs[0], dirs[1], &exclusions, &opts);
+  printf("-------------------------------\n");
+  vec_destroy(&exclusions);
+  return ok;
+}
+
 int main(int argc, const char **argv) {
   bump_t arena;
   bump_init(&arena);
@@ -229,17 +622,13 @@ int main(int argc, const char **argv) {
 
   bool success = false;
   if (slice_equals_cstr(arg, "clean")) {
-    printf("--- cnote: Cleaning ---\n");
     success = cmd_clean(&alc, &p);
-    printf("-------------------------\n");
   } else if (slice_equals_cstr(arg, "doc")) {
-    printf("--- cnote: Generating Docs ---\n");
     success = cmd_doc(&alc, &p);
-    printf("------------------------------\n");
   } else if (slice_equals_cstr(arg, "license")) {
-    printf("--- cnote: Applying License ---\n");
     success = cmd_license(&alc, &p);
-    printf("-------------------------------\n");
+  } else if (slice_equals_cstr(arg, "all")) {
+    success = cmd_all(&alc, &p);
   } else {
     fprintf(stderr, "Error: Unknown command '%.*s'\n", (int)arg.len, arg.ptr);
     print_usage();
@@ -0,0 +1,125 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <path_list.h>
+
+#include <std/string/string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PATH_LIST_CHUNK (64 * 1024)
+
+/**
+ * @brief (辅助) 交出一条已拼好的路径; 空路径直接丢弃
+ */
+static bool emit(string_t *pending, bool nul_separated, path_list_fn_t fn,
+                 void *ctx) {
+  str_slice_t path = string_as_slice(pending);
+  if (!nul_separated && path.len > 0 && path.ptr[path.len - 1] == '\r')
+    path.len--;
+  bool keep_going = true;
+  if (path.len > 0) {
+    /* 去掉 `\r` 后重新以 NUL 结尾 */
+    ((char *)path.ptr)[path.len] = '\0';
+    keep_going = fn(ctx, path.ptr);
+  }
+  string_clear(pending);
+  return keep_going;
+}
+
+bool path_list_read(allocer_t *alc, const char *source, path_list_fn_t fn,
+                    void *ctx) {
+  if (strcmp(source, "-") == 0)
+    return path_list_read_fd(alc, STDIN_FILENO, "<stdin>", fn, ctx);
+
+  int fd = open(source, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "Error: Could not open path list '%s': %s\n", source,
+            strerror(errno));
+    return false;
+  }
+  bool ok = path_list_read_fd(alc, fd, source, fn, ctx);
+  close(fd);
+  return ok;
+}
+
+bool path_list_read_fd(allocer_t *alc, int fd, const char *name,
+                       path_list_fn_t fn, void *ctx) {
+  string_t pending;
+  if (!string_init(&pending, alc, 256))
+    return false;
+
+  char buf[PATH_LIST_CHUNK];
+  /* 分隔符由第一个出现的 NUL 或换行决定; 之前的字节先攒在 pending 中 */
+  bool decided = false;
+  bool nul_separated = false;
+  bool ok = true;
+
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "Error: Could not read path list '%s': %s\n", name,
+              strerror(errno));
+      ok = false;
+      break;
+    }
+    if (n == 0)
+      break;
+
+    const char *p = buf;
+    const char *end = buf + n;
+    if (!decided) {
+      const char *q = p;
+      while (q < end && *q != '\0' && *q != '\n') {
+        q++;
+      }
+      if (q == end) {
+        string_append_slice(&pending,
+                            (str_slice_t){.ptr = p, .len = (size_t)n});
+        continue;
+      }
+      nul_separated = *q == '\0';
+      decided = true;
+    }
+    char sep = nul_separated ? '\0' : '\n';
+
+    while (ok && p < end) {
+      const char *rec_end = memchr(p, sep, (size_t)(end - p));
+      const char *stop = rec_end ? rec_end : end;
+      string_append_slice(&pending,
+                          (str_slice_t){.ptr = p, .len = (size_t)(stop - p)});
+      if (!rec_end)
+        break;
+      ok = emit(&pending, nul_separated, fn, ctx);
+      p = rec_end + 1;
+    }
+    if (!ok)
+      break;
+  }
+
+  if (ok)
+    ok = emit(&pending, nul_separated, fn, ctx);
+
+  string_destroy(&pending);
+  return ok;
+}
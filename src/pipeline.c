@@ -0,0 +1,370 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <atomic_file.h>
+#include <clang_format.h>
+#include <doc.h>
+#include <exclude.h>
+#include <license.h>
+#include <pipeline.h>
+#include <pool.h>
+#include <report.h>
+#include <scan.h>
+#include <strip.h>
+#include <walk.h>
+
+#include <core/mem/layout.h>
+#include <std/io/file.h>
+#include <std/string/str_slice.h>
+#include <std/string/string.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief (辅助) 复制一个 C 字符串到 Arena
+ */
+static inline char *allocer_strdup(allocer_t *alc, const char *s) {
+  size_t len = strlen(s);
+  layout_t layout = layout_of_array(char, len + 1);
+  char *new_s = allocer_alloc(alc, layout);
+  if (new_s) {
+    memcpy(new_s, s, len + 1);
+  }
+  return new_s;
+}
+
+bool pipeline_parse_steps(const char *spec, unsigned *steps) {
+  static const struct {
+    const char *name;
+    pipeline_step_t step;
+  } names[] = {
+      {"license", PIPELINE_LICENSE},
+      {"clean", PIPELINE_CLEAN},
+      {"doc", PIPELINE_DOC},
+  };
+
+  *steps = 0;
+  const char *p = spec;
+  for (;;) {
+    const char *comma = strchr(p, ',');
+    size_t len = comma ? (size_t)(comma - p) : strlen(p);
+    bool known = false;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+      if (strlen(names[i].name) == len && strncmp(p, names[i].name, len) == 0) {
+        *steps |= names[i].step;
+        known = true;
+      }
+    }
+    if (!known) {
+      fprintf(stderr,
+              "Error: Unknown pipeline step '%.*s' (expected license, clean "
+              "or doc)\n",
+              (int)len, p);
+      return false;
+    }
+    if (!comma)
+      return true;
+    p = comma + 1;
+  }
+}
+
+typedef struct {
+  const pipeline_opts_t *opts;
+  /* 仅 license 步骤: 许可证注释块 */
+  str_slice_t header;
+  /* 仅 doc 步骤: 输出站点 */
+  const doc_site_t *site;
+} pipeline_ctx_t;
+
+/**
+ * @brief 一个待处理的文件; 除路径外都由工作线程填写
+ */
+typedef struct {
+  const char *path;
+  /* 仅 doc 步骤: 相对路径与解析出的条目, `entries` 为 NULL 表示解析失败 */
+  doc_index_file_t doc;
+  bool ok;
+  bool written;
+} pipeline_file_t;
+
+/**
+ * @brief (工作线程) 在内存中应用许可证头
+ *
+ * @return false 开头的块注释没有闭合, `content` 保持不变
+ */
+static bool apply_license_step(allocer_t *alc, str_slice_t header,
+                               const char *path, str_slice_t *content,
+                               report_t *rep) {
+  size_t body_offset;
+  switch (license_check_buffer(header, *content, &body_offset)) {
+  case LICENSE_PRESENT:
+    return true;
+  case LICENSE_MALFORMED:
+    report_err(rep,
+               "Warning: Skipping license for '%s' (malformed block comment "
+               "at start)\n",
+               path);
+    return false;
+  case LICENSE_MISSING:
+  case LICENSE_OUTDATED:
+    break;
+  }
+
+  string_t out;
+  if (!string_init(&out, alc, header.len + content->len))
+    return false;
+  string_append_slice(&out, header);
+  string_append_slice(&out,
+                      (str_slice_t){.ptr = content->ptr + body_offset,
+                                    .len = content->len - body_offset});
+  *content = string_as_slice(&out);
+  return true;
+}
+
+/**
+ * @brief (工作线程) 删除 `//` 注释并经管道格式化
+ *
+ * @return false clang-format 失败, `content` 保持不变
+ */
+static bool apply_clean_step(allocer_t *alc, const char *style_file,
+                             const char *path, str_slice_t *content,
+                             report_t *rep) {
+  string_t stripped, formatted;
+  if (!string_init(&stripped, alc, content->len) ||
+      !string_init(&formatted, alc, content->len + 256))
+    return false;
+
+  strip_line_comments(scan_select(), *content, &stripped);
+  if (!clang_format_pipe(alc, style_file, path, string_as_slice(&stripped),
+                         &formatted, rep))
+    return false;
+  *content = string_as_slice(&formatted);
+  return true;
+}
+
+static bool write_result(allocer_t *alc, const char *path,
+                         str_slice_t content) {
+  atomic_file_t af;
+  if (!atomic_file_open(&af, alc, path)) {
+    atomic_file_abort(&af);
+    return false;
+  }
+  if (!atomic_file_write(&af, content.ptr, content.len)) {
+    atomic_file_abort(&af);
+    return false;
+  }
+  return atomic_file_commit(&af);
+}
+
+static bool pipeline_job(void *ctx, job_worker_t *worker, void *job,
+                         report_t *rep) {
+  pipeline_ctx_t *pctx = ctx;
+  pipeline_file_t *file = job;
+  allocer_t *alc = &worker->scratch;
+  unsigned steps = pctx->opts->steps;
+
+  str_slice_t original;
+  if (!read_file_to_slice(alc, file->path, &original)) {
+    report_err(rep, "Error: Failed to read file '%s'.\n", file->path);
+    return false;
+  }
+
+  /* 某一步失败时跳过它, 后续步骤仍作用于之前的结果 */
+  bool ok = true;
+  str_slice_t content = original;
+  if (steps & PIPELINE_LICENSE)
+    ok &= apply_license_step(alc, pctx->header, file->path, &content, rep);
+  if (steps & PIPELINE_CLEAN)
+    ok &= apply_clean_step(alc, pctx->opts->style_file, file->path, &content,
+                           rep);
+
+  if (content.len != original.len ||
+      memcmp(content.ptr, original.ptr, content.len) != 0) {
+    report_out(rep, "  Updated: %s\n", file->path);
+    if (write_result(alc, file->path, content)) {
+      file->written = true;
+    } else {
+      report_err(rep, "Error: Failed to write file '%s'.\n", file->path);
+      ok = false;
+      content = original;
+    }
+  }
+
+  /* 条目要活到所有页面生成之后, 不能放在 scratch 中 */
+  if (steps & PIPELINE_DOC)
+    ok &= doc_site_parse(alc, &worker->alc, content, &file->doc);
+
+  file->ok = ok;
+  return ok;
+}
+
+typedef struct {
+  allocer_t *alc;
+  const exclude_set_t *exclude;
+  bool verbose;
+  size_t base_len;
+  job_pool_t *pool;
+  vec_t *files;
+  /* 有子目录打不开或文件无法 stat: 本次没有看到完整的源文件列表 */
+  bool walk_error;
+} pipeline_walk_t;
+
+static bool is_source_file(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  if (!dot)
+    return false;
+  return strcmp(dot, ".c") == 0 || strcmp(dot, ".h") == 0;
+}
+
+static bool pipeline_visit(void *ctx, const walk_entry_t *entry) {
+  pipeline_walk_t *walk = ctx;
+  const char *full_path = entry->path.ptr;
+
+  switch (entry->kind) {
+  case WALK_ERR_OPEN_DIR:
+    walk->walk_error = true;
+    job_pool_note(walk->pool, stderr,
+                  "Warning: Could not open directory '%s'\n", full_path);
+    return false;
+  case WALK_ERR_STAT:
+    walk->walk_error = true;
+    job_pool_note(walk->pool, stderr, "Warning: Could not stat file '%s'\n",
+                  full_path);
+    return false;
+  default:
+    break;
+  }
+
+  const char *pattern = exclude_match(walk->exclude, entry->path,
+                                      entry->kind == WALK_DIR);
+  if (pattern) {
+    if (walk->verbose) {
+      job_pool_note(walk->pool, stdout, "  Excluding: %s (matches '%s')\n",
+                    full_path, pattern);
+    }
+    return false;
+  }
+
+  if (entry->kind != WALK_FILE || !is_source_file(full_path))
+    return true;
+
+  char *stable_path = allocer_strdup(walk->alc, full_path);
+  pipeline_file_t *file = allocer_alloc(walk->alc, layout_of(pipeline_file_t));
+  if (!stable_path || !file)
+    return true;
+  memset(file, 0, sizeof(*file));
+  file->path = stable_path;
+
+  const char *relative_path = stable_path + walk->base_len;
+  if (relative_path[0] == '/')
+    relative_path++;
+  file->doc.relative_path = slice_from_cstr(relative_path);
+
+  if (vec_push(walk->files, file))
+    job_pool_submit(walk->pool, file);
+  return true;
+}
+
+bool cnote_pipeline_run(allocer_t *alc, const char *src_dir,
+                        const char *out_dir, vec_t *exclusions,
+                        const pipeline_opts_t *opts) {
+  pipeline_ctx_t ctx = {.opts = opts};
+
+  string_t header;
+  if (opts->steps & PIPELINE_LICENSE) {
+    if (!license_header_load(alc, opts->license_file, &header))
+      return false;
+    ctx.header = string_as_slice(&header);
+  }
+
+  doc_site_t site;
+  if (opts->steps & PIPELINE_DOC) {
+    if (!doc_site_open(&site, alc, out_dir))
+      return false;
+    site.split_above = opts->split_above;
+    ctx.site = &site;
+  }
+
+  exclude_set_t exclude;
+  vec_t files;
+  if (!exclude_set_init(&exclude, alc, exclusions) ||
+      !vec_init(&files, alc, 0))
+    return false;
+
+  char *stable_src_dir = allocer_strdup(alc, src_dir);
+  if (!stable_src_dir)
+    return false;
+
+  job_pool_t pool;
+  if (!job_pool_init(&pool, alc, opts->jobs, pipeline_job, &ctx))
+    return false;
+
+  pipeline_walk_t walk = {
+      .alc = alc,
+      .exclude = &exclude,
+      .verbose = opts->verbose,
+      .base_len = strlen(stable_src_dir),
+      .pool = &pool,
+      .files = &files,
+      .walk_error = false,
+  };
+  bool walk_ok = walk_tree(alc, stable_src_dir,
+                           opts->no_ignore ? WALK_NO_FLAGS : WALK_HONOR_IGNORE,
+                           pipeline_visit, &walk);
+  if (!walk_ok)
+    fprintf(stderr, "Error: Could not open directory '%s'\n", src_dir);
+  bool jobs_ok = job_pool_wait(&pool);
+
+  size_t n_files = vec_count(&files);
+  size_t n_changed = 0, n_failed = 0, n_docs = 0;
+  doc_index_file_t *docs =
+      allocer_alloc(alc, layout_of_array(doc_index_file_t, n_files + 1));
+  if (!docs)
+    return false;
+  for (size_t i = 0; i < n_files; i++) {
+    pipeline_file_t *file = vec_get(&files, i);
+    if (file->written)
+      n_changed++;
+    if (!file->ok)
+      n_failed++;
+    if (file->doc.entries)
+      docs[n_docs++] = file->doc;
+  }
+  printf("  %zu file(s) changed, %zu unchanged", n_changed,
+         n_files - n_changed);
+  if (n_failed > 0)
+    printf(", %zu failed", n_failed);
+  printf(".\n");
+
+  /* 遍历不完整时 SUMMARY 会漏掉没看到的源文件, 保留上次的页面 */
+  bool complete = walk_ok && !walk.walk_error;
+  bool docs_ok = true;
+  if ((opts->steps & PIPELINE_DOC) && !complete) {
+    fprintf(stderr, "Warning: Source tree was not fully read; "
+                    "pages and SUMMARY.md are left as they were\n");
+  } else if (opts->steps & PIPELINE_DOC) {
+    printf("  Writing pages and SUMMARY.md to `%s`...\n", out_dir);
+    docs_ok =
+        doc_site_render_all(&site, alc, docs, n_docs, opts->jobs, NULL);
+  }
+
+  job_pool_destroy(&pool);
+  vec_destroy(&files);
+  if (opts->steps & PIPELINE_LICENSE)
+    string_destroy(&header);
+  return complete && jobs_ok && docs_ok;
+}
@@ -0,0 +1,294 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <pool.h>
+
+#include <core/mem/layout.h>
+#include <std/allocer/bump/glue.h>
+
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+struct job_slot {
+  void *job;
+  report_t report;
+  bool done;
+};
+
+size_t job_pool_default_workers(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
+}
+
+static bool deque_push(job_worker_t *w, allocer_t *alc, job_slot_t *slot) {
+  pthread_mutex_lock(&w->lock);
+  if (w->count == w->cap) {
+    size_t new_cap = w->cap ? w->cap * 2 : 64;
+    job_slot_t **new_ring =
+        allocer_alloc(alc, layout_of_array(job_slot_t *, new_cap));
+    if (!new_ring) {
+      pthread_mutex_unlock(&w->lock);
+      return false;
+    }
+    for (size_t i = 0; i < w->count; i++) {
+      new_ring[i] = w->ring[(w->head + i) % w->cap];
+    }
+    w->ring = new_ring;
+    w->head = 0;
+    w->cap = new_cap;
+  }
+  w->ring[(w->head + w->count) % w->cap] = slot;
+  w->count++;
+  pthread_mutex_unlock(&w->lock);
+  return true;
+}
+
+static job_slot_t *deque_pop_front(job_worker_t *w) {
+  job_slot_t *slot = NULL;
+  pthread_mutex_lock(&w->lock);
+  if (w->count > 0) {
+    slot = w->ring[w->head];
+    w->head = (w->head + 1) % w->cap;
+    w->count--;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return slot;
+}
+
+static job_slot_t *deque_steal_back(job_worker_t *w) {
+  job_slot_t *slot = NULL;
+  pthread_mutex_lock(&w->lock);
+  if (w->count > 0) {
+    slot = w->ring[(w->head + w->count - 1) % w->cap];
+    w->count--;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return slot;
+}
+
+/**
+ * @brief (需持有 out_lock) 按提交顺序刷出所有已完成的输出
+ */
+static void flush_ready(job_pool_t *pool) {
+  while (pool->flushed < vec_count(&pool->slots)) {
+    job_slot_t *slot = vec_get(&pool->slots, pool->flushed);
+    if (!slot->done)
+      break;
+    report_flush(&slot->report);
+    pool->flushed++;
+  }
+}
+
+/**
+ * @brief 释放上一个任务的临时分配
+ */
+static void reset_scratch(job_worker_t *w) {
+  bump_destroy(&w->scratch_arena);
+  bump_init(&w->scratch_arena);
+  w->scratch = bump_to_allocer(&w->scratch_arena);
+}
+
+static void run_slot(job_pool_t *pool, job_worker_t *w, job_slot_t *slot) {
+  bool ok = report_init(&slot->report, &w->alc);
+  if (ok && !job_pool_cancelled(pool))
+    ok = pool->fn(pool->ctx, w, slot->job, &slot->report);
+  reset_scratch(w);
+
+  pthread_mutex_lock(&pool->out_lock);
+  if (!ok)
+    pool->failed++;
+  slot->done = true;
+  flush_ready(pool);
+  pthread_mutex_unlock(&pool->out_lock);
+}
+
+static void *worker_main(void *arg) {
+  job_worker_t *w = arg;
+  job_pool_t *pool = w->pool;
+
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued == 0 && !pool->closing) {
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    if (pool->queued == 0) {
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+    pool->queued--;
+    pthread_mutex_unlock(&pool->lock);
+
+    /* 已经预留了一个任务, 它一定在某个队列里 */
+    job_slot_t *slot = deque_pop_front(w);
+    for (size_t i = 1; slot == NULL; i++) {
+      slot = deque_steal_back(&pool->workers[(w->id + i) % pool->n_threads]);
+    }
+    run_slot(pool, w, slot);
+  }
+  return NULL;
+}
+
+bool job_pool_init(job_pool_t *pool, allocer_t *alc, size_t n_workers,
+                   job_fn_t fn, void *ctx) {
+  memset(pool, 0, sizeof(*pool));
+  if (n_workers == 0)
+    n_workers = 1;
+
+  pool->alc = alc;
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->n_workers = n_workers;
+
+  pool->workers = allocer_alloc(alc, layout_of_array(job_worker_t, n_workers));
+  if (!pool->workers || !vec_init(&pool->slots, alc, 0))
+    return false;
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pthread_mutex_init(&pool->out_lock, NULL);
+
+  for (size_t i = 0; i < n_workers; i++) {
+    job_worker_t *w = &pool->workers[i];
+    memset(w, 0, sizeof(*w));
+    w->pool = pool;
+    w->id = i;
+    bump_init(&w->arena);
+    w->alc = bump_to_allocer(&w->arena);
+    bump_init(&w->scratch_arena);
+    w->scratch = bump_to_allocer(&w->scratch_arena);
+    pthread_mutex_init(&w->lock, NULL);
+  }
+
+  if (n_workers > 1) {
+    for (size_t i = 0; i < n_workers; i++) {
+      if (pthread_create(&pool->workers[i].thread, NULL, worker_main,
+                         &pool->workers[i]) != 0) {
+        fprintf(stderr, "Warning: Could only start %zu of %zu workers\n", i,
+                n_workers);
+        break;
+      }
+      pool->n_threads++;
+    }
+  }
+  return true;
+}
+
+bool job_pool_submit(job_pool_t *pool, void *job) {
+  job_slot_t *slot = allocer_alloc(pool->alc, layout_of(job_slot_t));
+  if (!slot)
+    return false;
+  slot->job = job;
+  slot->done = false;
+
+  pthread_mutex_lock(&pool->out_lock);
+  bool pushed = vec_push(&pool->slots, slot);
+  pthread_mutex_unlock(&pool->out_lock);
+  if (!pushed)
+    return false;
+
+  if (pool->n_threads == 0) {
+    run_slot(pool, &pool->workers[0], slot);
+    return true;
+  }
+
+  job_worker_t *w = &pool->workers[pool->next_worker];
+  pool->next_worker = (pool->next_worker + 1) % pool->n_threads;
+  if (!deque_push(w, pool->alc, slot)) {
+    /* 入队失败: 标记为已完成的失败槽位, 以免阻塞后续输出 */
+    pthread_mutex_lock(&pool->out_lock);
+    report_init(&slot->report, pool->alc);
+    pool->failed++;
+    slot->done = true;
+    flush_ready(pool);
+    pthread_mutex_unlock(&pool->out_lock);
+    return false;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->queued++;
+  pthread_cond_signal(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+  return true;
+}
+
+void job_pool_note(job_pool_t *pool, FILE *stream, const char *fmt, ...) {
+  job_slot_t *slot = allocer_alloc(pool->alc, layout_of(job_slot_t));
+  if (!slot || !report_init(&slot->report, pool->alc))
+    return;
+  slot->job = NULL;
+
+  char buf[1024];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (stream == stderr) {
+    report_err(&slot->report, "%s", buf);
+  } else {
+    report_out(&slot->report, "%s", buf);
+  }
+
+  pthread_mutex_lock(&pool->out_lock);
+  slot->done = true;
+  if (vec_push(&pool->slots, slot))
+    flush_ready(pool);
+  pthread_mutex_unlock(&pool->out_lock);
+}
+
+void job_pool_cancel(job_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->cancelled = true;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+bool job_pool_cancelled(job_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  bool cancelled = pool->cancelled;
+  pthread_mutex_unlock(&pool->lock);
+  return cancelled;
+}
+
+bool job_pool_wait(job_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->closing = true;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->n_threads; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+  pool->n_threads = 0;
+
+  pthread_mutex_lock(&pool->out_lock);
+  flush_ready(pool);
+  bool ok = pool->failed == 0;
+  pthread_mutex_unlock(&pool->out_lock);
+  fflush(stdout);
+  return ok;
+}
+
+void job_pool_destroy(job_pool_t *pool) {
+  for (size_t i = 0; i < pool->n_workers; i++) {
+    pthread_mutex_destroy(&pool->workers[i].lock);
+    bump_destroy(&pool->workers[i].arena);
+    bump_destroy(&pool->workers[i].scratch_arena);
+  }
+  vec_destroy(&pool->slots);
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->out_lock);
+  pthread_mutex_destroy(&pool->lock);
+}
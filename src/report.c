@@ -0,0 +1,77 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <report.h>
+
+#include <core/mem/layout.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+bool report_init(report_t *rep, allocer_t *alc) {
+  rep->alc = alc;
+  return string_init(&rep->out, alc, 64) && string_init(&rep->err, alc, 0);
+}
+
+static void report_vappend(report_t *rep, string_t *dst, const char *fmt,
+                           va_list ap) {
+  char stack_buf[512];
+  va_list ap2;
+  va_copy(ap2, ap);
+  int n = vsnprintf(stack_buf, sizeof(stack_buf), fmt, ap);
+  if (n < 0) {
+    va_end(ap2);
+    return;
+  }
+  if ((size_t)n < sizeof(stack_buf)) {
+    string_append_slice(dst, (str_slice_t){.ptr = stack_buf, .len = (size_t)n});
+  } else {
+    char *heap_buf = allocer_alloc(rep->alc, layout_of_array(char, n + 1));
+    if (heap_buf) {
+      vsnprintf(heap_buf, (size_t)n + 1, fmt, ap2);
+      string_append_slice(dst, (str_slice_t){.ptr = heap_buf, .len = (size_t)n});
+    }
+  }
+  va_end(ap2);
+}
+
+void report_out(report_t *rep, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  report_vappend(rep, &rep->out, fmt, ap);
+  va_end(ap);
+}
+
+void report_err(report_t *rep, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  report_vappend(rep, &rep->err, fmt, ap);
+  va_end(ap);
+}
+
+void report_flush(report_t *rep) {
+  str_slice_t out = string_as_slice(&rep->out);
+  str_slice_t err = string_as_slice(&rep->err);
+  if (out.len > 0) {
+    fwrite(out.ptr, 1, out.len, stdout);
+    string_clear(&rep->out);
+  }
+  if (err.len > 0) {
+    fflush(stdout);
+    fwrite(err.ptr, 1, err.len, stderr);
+    string_clear(&rep->err);
+  }
+}
@@ -0,0 +1,137 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <scan.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_HAVE_X86 1
+#else
+#define SCAN_HAVE_X86 0
+#endif
+
+void scan_set_init(scan_set_t *set, const char *chars) {
+  memset(set, 0, sizeof(*set));
+  for (const char *c = chars; *c && set->n < SCAN_MAX_NEEDLES; c++) {
+    set->chars[set->n++] = *c;
+    set->member[(unsigned char)*c] = true;
+  }
+}
+
+static const char *scan_any_scalar(const char *p, const char *end,
+                                   const scan_set_t *set) {
+  if (set->n == 1) {
+    const char *hit = memchr(p, set->chars[0], (size_t)(end - p));
+    return hit ? hit : end;
+  }
+  while (p < end && !set->member[(unsigned char)*p]) {
+    p++;
+  }
+  return p;
+}
+
+#if SCAN_HAVE_X86
+
+static const char *scan_any_sse2(const char *p, const char *end,
+                                 const scan_set_t *set) {
+  __m128i needles[SCAN_MAX_NEEDLES];
+  for (size_t i = 0; i < set->n; i++) {
+    needles[i] = _mm_set1_epi8(set->chars[i]);
+  }
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i hit = _mm_cmpeq_epi8(v, needles[0]);
+    for (size_t i = 1; i < set->n; i++) {
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[i]));
+    }
+    unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+    p += 16;
+  }
+  return scan_any_scalar(p, end, set);
+}
+
+__attribute__((target("avx2"))) static const char *
+scan_any_avx2(const char *p, const char *end, const scan_set_t *set) {
+  __m256i needles[SCAN_MAX_NEEDLES];
+  for (size_t i = 0; i < set->n; i++) {
+    needles[i] = _mm256_set1_epi8(set->chars[i]);
+  }
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i hit = _mm256_cmpeq_epi8(v, needles[0]);
+    for (size_t i = 1; i < set->n; i++) {
+      hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, needles[i]));
+    }
+    unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+    p += 32;
+  }
+  return scan_any_sse2(p, end, set);
+}
+
+#endif
+
+scan_fn_t scan_impl(const char *name) {
+  if (strcmp(name, "scalar") == 0)
+    return scan_any_scalar;
+#if SCAN_HAVE_X86
+  if (strcmp(name, "sse2") == 0)
+    return scan_any_sse2;
+  if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+    return scan_any_avx2;
+#endif
+  return NULL;
+}
+
+static pthread_once_t select_once = PTHREAD_ONCE_INIT;
+static scan_fn_t selected_fn;
+static const char *selected_name;
+
+static void select_impl(void) {
+  static const char *const preferred[] = {"avx2", "sse2", "scalar"};
+
+  const char *forced = getenv("CNOTE_SCAN");
+  if (forced && scan_impl(forced)) {
+    selected_fn = scan_impl(forced);
+    selected_name = forced;
+    return;
+  }
+  for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++) {
+    scan_fn_t fn = scan_impl(preferred[i]);
+    if (fn) {
+      selected_fn = fn;
+      selected_name = preferred[i];
+      return;
+    }
+  }
+}
+
+scan_fn_t scan_select(void) {
+  pthread_once(&select_once, select_impl);
+  return selected_fn;
+}
+
+const char *scan_impl_name(void) {
+  pthread_once(&select_once, select_impl);
+  return selected_name;
+}
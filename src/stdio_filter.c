@@ -0,0 +1,66 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <stdio_filter.h>
+
+#include <std/string/string.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STDIO_FILTER_CHUNK (64 * 1024)
+
+bool stdio_filter_read(allocer_t *alc, str_slice_t *out) {
+  string_t buf;
+  if (!string_init(&buf, alc, STDIO_FILTER_CHUNK))
+    return false;
+
+  char chunk[STDIO_FILTER_CHUNK];
+  for (;;) {
+    ssize_t n = read(STDIN_FILENO, chunk, sizeof(chunk));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "Error: Could not read stdin: %s\n", strerror(errno));
+      return false;
+    }
+    if (n == 0)
+      break;
+    string_append_slice(&buf, (str_slice_t){.ptr = chunk, .len = (size_t)n});
+  }
+  size_t len = string_as_slice(&buf).len;
+  *out = (str_slice_t){.ptr = string_as_cstr(&buf), .len = len};
+  return true;
+}
+
+bool stdio_filter_write(str_slice_t data) {
+  /* 之前可能有经 stdio 缓冲的输出, 先刷出以保持顺序 */
+  fflush(stdout);
+  size_t written = 0;
+  while (written < data.len) {
+    ssize_t n = write(STDOUT_FILENO, data.ptr + written, data.len - written);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "Error: Could not write stdout: %s\n", strerror(errno));
+      return false;
+    }
+    written += (size_t)n;
+  }
+  return true;
+}
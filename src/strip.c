@@ -0,0 +1,86 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include <strip.h>
+
+#include <lex.h>
+
+static inline void append_span(string_t *out, const char *from,
+                               const char *to) {
+  if (to > from) {
+    string_append_slice(out,
+                        (str_slice_t){.ptr = from, .len = (size_t)(to - from)});
+  }
+}
+
+void strip_line_comments(scan_fn_t find, str_slice_t src, string_t *out) {
+  lexer_t lx;
+  lexer_init(&lx, find, src);
+
+  /* 片段首尾相接: 两个行注释之间的内容一次性整段追加 */
+  const char *kept = src.ptr;
+  lex_token_t tok;
+  while (lexer_next(&lx, &tok)) {
+    if (tok.kind == LEX_LINE_COMMENT) {
+      append_span(out, kept, tok.text.ptr);
+      kept = tok.text.ptr + tok.text.len;
+    }
+  }
+  append_span(out, kept, src.ptr + src.len);
+}
+
+typedef struct {
+  atomic_file_t *out;
+  /* 攒满 LEX_STREAM_CHUNK 字节再写, 避免每个片段一次系统调用 */
+  string_t pending;
+  size_t removed;
+} strip_stream_t;
+
+static bool flush_pending(strip_stream_t *st) {
+  str_slice_t data = string_as_slice(&st->pending);
+  if (st->out && data.len > 0 &&
+      !atomic_file_write(st->out, data.ptr, data.len))
+    return false;
+  string_clear(&st->pending);
+  return true;
+}
+
+static bool strip_sink(void *ctx, const lex_token_t *tok) {
+  strip_stream_t *st = ctx;
+  if (tok->kind == LEX_LINE_COMMENT) {
+    st->removed++;
+    return true;
+  }
+  if (!st->out)
+    return true;
+  string_append_slice(&st->pending, tok->text);
+  if (string_as_slice(&st->pending).len >= LEX_STREAM_CHUNK)
+    return flush_pending(st);
+  return true;
+}
+
+bool strip_line_comments_fd(allocer_t *alc, scan_fn_t find, int fd,
+                            atomic_file_t *out, size_t *removed) {
+  strip_stream_t st = {.out = out, .removed = 0};
+  if (!string_init(&st.pending, alc, out ? LEX_STREAM_CHUNK * 2 : 1))
+    return false;
+
+  bool ok = lex_stream_fd(alc, find, fd, LEX_STREAM_CHUNK, strip_sink, &st) &&
+            flush_pending(&st);
+  string_destroy(&st.pending);
+  *removed = st.removed;
+  return ok;
+}
@@ -0,0 +1,244 @@
+/*
+ *    Copyright 2025 Karesis
+ * 
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ * 
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <ignore.h>
+#include <walk.h>
+
+#include <core/mem/layout.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+  DIR *dir;
+  size_t path_len;
+} walk_frame_t;
+
+typedef struct {
+  allocer_t *alc;
+  char *buf;
+  size_t len;
+  size_t cap;
+  walk_frame_t *frames;
+  size_t depth;
+  size_t max_depth;
+  /* 仅 WALK_HONOR_IGNORE: 规则栈与 root 部分 (含 `/`) 的长度 */
+  ignore_stack_t *ignore;
+  size_t root_len;
+} walker_t;
+
+static bool path_reserve(walker_t *w, size_t extra) {
+  if (w->len + extra + 1 <= w->cap)
+    return true;
+  size_t new_cap = w->cap ? w->cap * 2 : 256;
+  while (new_cap < w->len + extra + 1) {
+    new_cap *= 2;
+  }
+  char *new_buf = allocer_alloc(w->alc, layout_of_array(char, new_cap));
+  if (!new_buf)
+    return false;
+  if (w->len)
+    memcpy(new_buf, w->buf, w->len);
+  w->buf = new_buf;
+  w->cap = new_cap;
+  return true;
+}
+
+static bool path_append(walker_t *w, const char *s, size_t n) {
+  if (!path_reserve(w, n))
+    return false;
+  memcpy(w->buf + w->len, s, n);
+  w->len += n;
+  w->buf[w->len] = '\0';
+  return true;
+}
+
+static bool push_frame(walker_t *w, DIR *dir) {
+  if (w->depth == w->max_depth) {
+    size_t new_max = w->max_depth ? w->max_depth * 2 : 32;
+    walk_frame_t *new_frames =
+        allocer_alloc(w->alc, layout_of_array(walk_frame_t, new_max));
+    if (!new_frames)
+      return false;
+    if (w->depth)
+      memcpy(new_frames, w->frames, w->depth * sizeof(walk_frame_t));
+    w->frames = new_frames;
+    w->max_depth = new_max;
+  }
+  w->frames[w->depth++] = (walk_frame_t){.dir = dir, .path_len = w->len};
+  return true;
+}
+
+static walk_kind_t kind_of_mode(mode_t mode) {
+  if (S_ISDIR(mode))
+    return WALK_DIR;
+  if (S_ISREG(mode))
+    return WALK_FILE;
+  return WALK_OTHER;
+}
+
+/**
+ * @brief 打开子目录并压栈; 失败时通过回调报告
+ */
+static bool enter_dir(walker_t *w, int parent_fd, const char *name,
+                      walk_entry_t *entry, walk_fn_t fn, void *ctx) {
+  int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  DIR *dir = fd >= 0 ? fdopendir(fd) : NULL;
+  if (!dir) {
+    if (fd >= 0)
+      close(fd);
+    entry->kind = WALK_ERR_OPEN_DIR;
+    fn(ctx, entry);
+    return true;
+  }
+  if (!path_append(w, "/", 1) || !push_frame(w, dir)) {
+    closedir(dir);
+    return false;
+  }
+  if (w->ignore) {
+    str_slice_t rel_dir = {.ptr = w->buf + w->root_len,
+                           .len = w->len - w->root_len};
+    if (!ignore_stack_push_dir(w->ignore, dirfd(dir), rel_dir))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief (辅助) 判断目录项是否被 .gitignore / .ignore 忽略
+ */
+static bool is_ignored(walker_t *w, const walk_entry_t *entry) {
+  bool is_dir = entry->kind == WALK_DIR;
+  if (is_dir && slice_equals_cstr(entry->name, ".git"))
+    return true;
+  str_slice_t rel = {.ptr = w->buf + w->root_len,
+                     .len = w->len - w->root_len};
+  return ignore_stack_match(w->ignore, rel, is_dir);
+}
+
+bool walk_tree(allocer_t *alc, const char *root, unsigned flags, walk_fn_t fn,
+               void *ctx) {
+  walker_t w = {.alc = alc};
+  ignore_stack_t ignore;
+  if (flags & WALK_HONOR_IGNORE) {
+    if (!ignore_stack_init(&ignore, alc, root))
+      return false;
+    w.ignore = &ignore;
+  }
+
+  size_t root_len = strlen(root);
+  if (!path_append(&w, root, root_len))
+    return false;
+
+  walk_entry_t root_entry = {
+      .kind = WALK_DIR,
+      .path = {.ptr = w.buf, .len = w.len},
+      .name = {.ptr = w.buf, .len = w.len},
+  };
+  DIR *root_dir = opendir(root);
+  if (!root_dir) {
+    root_entry.kind = WALK_ERR_OPEN_DIR;
+    fn(ctx, &root_entry);
+    return false;
+  }
+  if (root_len > 0 && root[root_len - 1] != '/' && !path_append(&w, "/", 1)) {
+    closedir(root_dir);
+    return false;
+  }
+  if (!push_frame(&w, root_dir)) {
+    closedir(root_dir);
+    return false;
+  }
+  w.root_len = w.len;
+  str_slice_t root_rel = {.ptr = w.buf, .len = 0};
+  if (w.ignore && !ignore_stack_push_dir(w.ignore, dirfd(root_dir), root_rel)) {
+    closedir(root_dir);
+    return false;
+  }
+
+  bool ok = true;
+  while (w.depth > 0) {
+    walk_frame_t *frame = &w.frames[w.depth - 1];
+    struct dirent *dp = readdir(frame->dir);
+    if (!dp) {
+      closedir(frame->dir);
+      w.depth--;
+      if (w.ignore)
+        ignore_stack_pop(w.ignore);
+      continue;
+    }
+
+    const char *name = dp->d_name;
+    if (name[0] == '.' &&
+        (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+      continue;
+
+    size_t name_len = strlen(name);
+    w.len = frame->path_len;
+    if (!path_append(&w, name, name_len)) {
+      ok = false;
+      break;
+    }
+
+    walk_entry_t entry = {
+        .path = {.ptr = w.buf, .len = w.len},
+        .name = {.ptr = w.buf + frame->path_len, .len = name_len},
+    };
+
+    int parent_fd = dirfd(frame->dir);
+    switch (dp->d_type) {
+    case DT_DIR:
+      entry.kind = WALK_DIR;
+      break;
+    case DT_REG:
+      entry.kind = WALK_FILE;
+      break;
+    case DT_LNK:
+    case DT_UNKNOWN: {
+      struct stat st;
+      if (fstatat(parent_fd, name, &st, 0) != 0) {
+        entry.kind = WALK_ERR_STAT;
+        fn(ctx, &entry);
+        continue;
+      }
+      entry.kind = kind_of_mode(st.st_mode);
+      break;
+    }
+    default:
+      entry.kind = WALK_OTHER;
+      break;
+    }
+
+    if (w.ignore && is_ignored(&w, &entry))
+      continue;
+
+    bool descend = fn(ctx, &entry);
+    if (entry.kind == WALK_DIR && descend &&
+        !enter_dir(&w, parent_fd, name, &entry, fn, ctx)) {
+      ok = false;
+      break;
+    }
+  }
+
+  while (w.depth > 0) {
+    closedir(w.frames[--w.depth].dir);
+  }
+  return ok;
+}